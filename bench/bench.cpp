@@ -0,0 +1,366 @@
+//throughput benchmark for parse (plain, instrumented and parallel), to_json, to_json_min (sequential and parallel), a parse+serialize round trip and the MessagePack encoding over generated documents
+//usage: json_bench [--sizes 1K,64K,1M,16M] [--corpus name,...] [--min-time seconds] [--json]
+//--json prints one JSON object per line instead of a table
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include "json.h"
+#include "json_msgpack.h"
+#include "json_parallel.h"
+#include "json_stats.h"
+
+//every allocation in the process goes through here, so allocations per document can be counted
+static std::atomic<size_t> allocations{0};
+
+void * operator new(size_t n){
+    allocations.fetch_add(1,std::memory_order_relaxed);
+    if(void * p=std::malloc(n?n:1))return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void * p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void * p,size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+    
+    using rng_t = std::mt19937_64;
+    
+    //appends a separator before every element but the first
+    struct list {
+        std::string &out;
+        const char * sep;
+        bool first=true;
+        
+        void next(){
+            if(!first)out+=sep;
+            first=false;
+        }
+    };
+    
+    void gen_numbers(std::string &out,size_t size,rng_t &rng){
+        std::uniform_real_distribution<double> real(-1e6,1e6);
+        char buf[32];
+        out+="[\n";
+        list rows{out,",\n"};
+        while(out.size()<size){
+            rows.next();
+            out+="[";
+            list row{out,","};
+            for(int j=0;j<16;j++){
+                row.next();
+                switch(rng()%4){
+                case 0:
+                    out+=std::to_string(static_cast<int64_t>(rng()%2000001)-1000000);
+                    break;
+                case 1:
+                    out+=std::to_string(static_cast<int64_t>(rng()));
+                    break;
+                case 2:
+                    snprintf(buf,sizeof(buf),"%.17g",real(rng));
+                    out+=buf;
+                    break;
+                default:
+                    snprintf(buf,sizeof(buf),"%.6e",real(rng)*1e-12);
+                    out+=buf;
+                    break;
+                }
+            }
+            out+="]";
+        }
+        out+="\n]";
+    }
+    
+    void append_random_string(std::string &out,rng_t &rng,size_t max_len){
+        static const char * const escapes[]={"\\\"","\\\\","\\n","\\t","\\/"};
+        size_t len=5+rng()%max_len;
+        out+='"';
+        for(size_t j=0;j<len;j++){
+            unsigned r=rng()%64;
+            if(r==0){
+                out+=escapes[rng()%5];
+            }else if(r==1){
+                out+="\xc3\xa9";//two byte utf-8
+            }else{
+                out+=static_cast<char>(r<10?' ':'a'+r%26);
+            }
+        }
+        out+='"';
+    }
+    
+    void gen_strings(std::string &out,size_t size,rng_t &rng){
+        out+="[\n";
+        list items{out,",\n"};
+        while(out.size()<size){
+            items.next();
+            append_random_string(out,rng,200);
+        }
+        out+="\n]";
+    }
+    
+    void gen_nested(std::string &out,size_t size,rng_t &rng){
+        const int depth=48;
+        out+="[\n";
+        list chains{out,",\n"};
+        while(out.size()<size){
+            chains.next();
+            for(int d=0;d<depth;d++){
+                if(d%2){
+                    out+="[";
+                }else{
+                    out+="{\"level\":"+std::to_string(d)+",\"child\":";
+                }
+            }
+            out+=std::to_string(rng()%1000);
+            for(int d=depth-1;d>=0;d--){
+                out+=d%2?"]":"}";
+            }
+        }
+        out+="\n]";
+    }
+    
+    void gen_wide(std::string &out,size_t size,rng_t &rng){
+        char key[32];
+        out+="{\n";
+        list members{out,",\n"};
+        for(size_t n=0;out.size()<size;n++){
+            members.next();
+            snprintf(key,sizeof(key),"\"key_%08zu\":",n);
+            out+=key;
+            switch(n%4){
+            case 0:
+                out+=std::to_string(rng()%100000);
+                break;
+            case 1:
+                append_random_string(out,rng,20);
+                break;
+            case 2:
+                out+=rng()%2?"true":"false";
+                break;
+            default:
+                out+="null";
+                break;
+            }
+        }
+        out+="\n}";
+    }
+    
+    void gen_comments(std::string &out,size_t size,rng_t &rng){
+        out+="// generated records\n[\n";
+        for(size_t n=0;out.size()<size;n++){
+            out+="    // record "+std::to_string(n)+"\n";
+            out+="    {\n        \"id\": "+std::to_string(n)+", /* inline comment */\n        \"name\": ";
+            append_random_string(out,rng,30);
+            out+=",\n        \"tags\": [\"a\", \"b\", \"c\",],\n        \"score\": "+std::to_string(rng()%1000)+".5,\n    },\n";
+        }
+        out+="]\n";
+    }
+    
+    struct corpus {
+        const char * name;
+        void (*generate)(std::string &out,size_t size,rng_t &rng);
+    };
+    
+    const corpus corpora[]={
+        {"numbers",gen_numbers},
+        {"strings",gen_strings},
+        {"nested",gen_nested},
+        {"wide",gen_wide},
+        {"comments",gen_comments},
+    };
+    
+    struct result {
+        std::string corpus;
+        size_t size;
+        std::string op;
+        size_t bytes;//bytes processed per iteration
+        size_t iterations;
+        double seconds;
+        size_t allocations;//per iteration
+        long peak_rss_kb;
+    };
+    
+    long peak_rss_kb(){
+        rusage r;
+        getrusage(RUSAGE_SELF,&r);
+#ifdef __APPLE__
+        return r.ru_maxrss/1024;
+#else
+        return r.ru_maxrss;
+#endif
+    }
+    
+    volatile size_t sink;//keeps the results of the benchmarked operations alive
+    
+    //runs op at least once and until min_time has passed, allocations are counted on the first run
+    result measure(const std::string &corpus_name,size_t size,const std::string &op_name,size_t bytes,double min_time,const std::function<size_t()> &op){
+        using clock = std::chrono::steady_clock;
+        result r{corpus_name,size,op_name,bytes,0,0,0,0};
+        size_t before=allocations.load(std::memory_order_relaxed);
+        auto start=clock::now();
+        sink=op();
+        r.allocations=allocations.load(std::memory_order_relaxed)-before;
+        r.iterations=1;
+        double elapsed=std::chrono::duration<double>(clock::now()-start).count();
+        while(elapsed<min_time){
+            sink=op();
+            r.iterations++;
+            elapsed=std::chrono::duration<double>(clock::now()-start).count();
+        }
+        r.seconds=elapsed;
+        r.peak_rss_kb=peak_rss_kb();
+        return r;
+    }
+    
+    size_t parse_size(const std::string &s){
+        char * end;
+        double v=strtod(s.c_str(),&end);
+        switch(*end){
+        case 'k':
+        case 'K':
+            v*=1024;
+            break;
+        case 'm':
+        case 'M':
+            v*=1024*1024;
+            break;
+        case 'g':
+        case 'G':
+            v*=1024*1024*1024;
+            break;
+        }
+        return static_cast<size_t>(v);
+    }
+    
+    std::vector<std::string> split(const std::string &s){
+        std::vector<std::string> parts;
+        size_t start=0;
+        while(start<=s.size()){
+            size_t comma=s.find(',',start);
+            if(comma==std::string::npos)comma=s.size();
+            if(comma>start)parts.push_back(s.substr(start,comma-start));
+            start=comma+1;
+        }
+        return parts;
+    }
+    
+    double mb_per_s(const result &r){
+        return r.seconds>0?static_cast<double>(r.bytes)*r.iterations/r.seconds/1e6:0;
+    }
+    
+    void print_json(const result &r){
+        JSON::Element::object_t o;
+        o.insert({"corpus",JSON::String(r.corpus)});
+        o.insert({"size",JSON::Int(r.size)});
+        o.insert({"op",JSON::String(r.op)});
+        o.insert({"bytes",JSON::Int(r.bytes)});
+        o.insert({"iterations",JSON::Int(r.iterations)});
+        o.insert({"seconds",JSON::Double(r.seconds)});
+        o.insert({"mb_per_s",JSON::Double(mb_per_s(r))});
+        o.insert({"allocations",JSON::Int(r.allocations)});
+        o.insert({"peak_rss_kb",JSON::Int(r.peak_rss_kb)});
+        std::cout<<JSON::Object(std::move(o)).to_json_min()<<std::endl;
+    }
+    
+    void print_row(const result &r){
+        printf("%-10s %12zu %-20s %12zu bytes %10.1f MB/s %12zu allocs %10ld KB peak\n",r.corpus.c_str(),r.size,r.op.c_str(),r.bytes,mb_per_s(r),r.allocations,r.peak_rss_kb);
+        fflush(stdout);
+    }
+
+}
+
+int main(int argc,char ** argv){
+    std::vector<std::string> sizes={"1K","64K","1M","16M"};
+    std::vector<std::string> only;
+    double min_time=0.25;
+    bool json=false;
+    for(int i=1;i<argc;i++){
+        std::string arg=argv[i];
+        if(arg=="--json"){
+            json=true;
+        }else if(arg=="--sizes"&&i+1<argc){
+            sizes=split(argv[++i]);
+        }else if(arg=="--corpus"&&i+1<argc){
+            only=split(argv[++i]);
+        }else if(arg=="--min-time"&&i+1<argc){
+            min_time=strtod(argv[++i],nullptr);
+        }else{
+            fprintf(stderr,"usage: %s [--sizes 1K,64K,1M,16M] [--corpus numbers,strings,nested,wide,comments] [--min-time seconds] [--json]\n",argv[0]);
+            return 1;
+        }
+    }
+    
+    auto report=json?print_json:print_row;
+    for(const corpus &c:corpora){
+        if(!only.empty()&&std::find(only.begin(),only.end(),c.name)==only.end())continue;
+        for(const std::string &size_str:sizes){
+            size_t size=parse_size(size_str);
+            std::string doc;
+            {
+                rng_t rng(size);//same seed for the same size, so runs are comparable
+                doc.reserve(size+4096);
+                c.generate(doc,size,rng);
+            }
+            
+            report(measure(c.name,size,"parse",doc.size(),min_time,[&]{
+                return JSON::parse(doc).is_arr();
+            }));
+            //same parse with instrumentation, the difference is what the stats cost
+            report(measure(c.name,size,"parse_stats",doc.size(),min_time,[&]{
+                JSON::ParseStats stats;
+                return JSON::parse(doc,stats).is_arr();
+            }));
+            report(measure(c.name,size,"parse_parallel",doc.size(),min_time,[&]{
+                return JSON::parse_parallel(doc).is_arr();
+            }));
+            
+            JSON::Element e=JSON::parse(doc);
+            std::string pretty=e.to_json();
+            std::string min=e.to_json_min();
+            report(measure(c.name,size,"to_json",pretty.size(),min_time,[&]{
+                return e.to_json().size();
+            }));
+            report(measure(c.name,size,"to_json_min",min.size(),min_time,[&]{
+                return e.to_json_min().size();
+            }));
+            report(measure(c.name,size,"to_json_parallel",pretty.size(),min_time,[&]{
+                return JSON::to_json_parallel(e).size();
+            }));
+            report(measure(c.name,size,"to_json_min_parallel",min.size(),min_time,[&]{
+                return JSON::to_json_min_parallel(e).size();
+            }));
+            
+            report(measure(c.name,size,"roundtrip",doc.size(),min_time,[&]{
+                return JSON::parse(JSON::parse(doc).to_json_min()).is_arr();
+            }));
+            
+            //bytes is the encoded size for the binary encoding, compare with to_json_min for the size difference
+            std::string packed=JSON::to_msgpack(e);
+            report(measure(c.name,size,"to_msgpack",packed.size(),min_time,[&]{
+                return JSON::to_msgpack(e).size();
+            }));
+            report(measure(c.name,size,"from_msgpack",packed.size(),min_time,[&]{
+                return JSON::from_msgpack(packed).is_arr();
+            }));
+            report(measure(c.name,size,"roundtrip_msgpack",packed.size(),min_time,[&]{
+                return JSON::from_msgpack(JSON::to_msgpack(e)).is_arr();
+            }));
+        }
+    }
+    return 0;
+}
@@ -5,6 +5,10 @@
 #include <vector>
 #include <map>
 #include <cstdint>
+#include <optional>
+#include <string_view>
+#include <iosfwd>
+#include "json_object_map.h"
 
 enum JSON_Literal {
     JSON_FALSE,
@@ -15,9 +19,20 @@ enum JSON_Literal {
 namespace JSON {
     class Element {
         public:
-            using data_t = std::variant<int64_t,double,std::string,std::vector<Element>,std::map<std::string,Element>,JSON_Literal>;
+            //objects are std::maps (sorted by key) by default, define JSON_ORDERED_OBJECTS when building to use ObjectMap (insertion ordered, hashed) instead
+            //the define must be the same for the library and everything using it
+            #ifdef JSON_ORDERED_OBJECTS
+            using object_t = ObjectMap<Element>;
+            #else
+            using object_t = std::map<std::string,Element>;
+            #endif
+            
+            using data_t = std::variant<int64_t,double,std::string,std::vector<Element>,object_t,JSON_Literal>;
             data_t data;
             
+            //null
+            inline Element() : data(JSON_NULL) {}
+            
             //explicit constructors using std::variant
             explicit inline Element(const data_t & v) : data(v) {}
             explicit inline Element(data_t && v) : data(std::move(v)) {}
@@ -45,8 +60,8 @@ namespace JSON {
             inline std::vector<Element>& get_arr(){ return std::get<std::vector<Element>>(data); }
             inline const std::vector<Element>& get_arr() const { return std::get<std::vector<Element>>(data); }
             
-            inline std::map<std::string,Element>& get_obj(){ return std::get<std::map<std::string,Element>>(data); }
-            inline const std::map<std::string,Element>& get_obj() const { return std::get<std::map<std::string,Element>>(data); }
+            inline object_t& get_obj(){ return std::get<object_t>(data); }
+            inline const object_t& get_obj() const { return std::get<object_t>(data); }
             
             inline JSON_Literal& get_lit() { return std::get<JSON_Literal>(data); }
             inline const JSON_Literal& get_lit() const { return std::get<JSON_Literal>(data); }
@@ -65,7 +80,7 @@ namespace JSON {
             
             inline bool is_arr() const { return std::holds_alternative<std::vector<Element>>(data); }
             
-            inline bool is_obj() const { return std::holds_alternative<std::map<std::string,Element>>(data); }
+            inline bool is_obj() const { return std::holds_alternative<object_t>(data); }
             
             inline bool is_lit() const { return std::holds_alternative<JSON_Literal>(data); }
             
@@ -74,10 +89,23 @@ namespace JSON {
             inline bool is_null() const { return std::holds_alternative<JSON_Literal>(data)&&std::get<JSON_Literal>(data)==JSON_NULL; }
             
             //serialize with spaces/newlines
-            std::string to_json(bool trailing_quote=true,size_t depth=0) const;
+            //control characters are written as \u00XX unless they have a short escape, ascii_only also writes everything outside ASCII as \uXXXX
+            std::string to_json(bool trailing_quote=true,size_t depth=0,bool ascii_only=false) const;
+            
+            //serialize with spaces/newlines, appending to an existing buffer, no temporaries are created per node
+            void to_json(std::string &out,bool trailing_quote=true,size_t depth=0,bool ascii_only=false) const;
+            
+            //serialize with spaces/newlines, writing to a stream through a bounded internal buffer
+            void to_json(std::ostream &out,bool trailing_quote=true,size_t depth=0,bool ascii_only=false) const;
             
             //serialize without spaces/newlines
-            std::string to_json_min() const;
+            std::string to_json_min(bool ascii_only=false) const;
+            
+            //serialize without spaces/newlines, appending to an existing buffer
+            void to_json_min(std::string &out,bool ascii_only=false) const;
+            
+            //serialize without spaces/newlines, writing to a stream through a bounded internal buffer
+            void to_json_min(std::ostream &out,bool ascii_only=false) const;
             
     };
     
@@ -87,12 +115,75 @@ namespace JSON {
     inline Element False(){ return Element(JSON_FALSE); }
     inline Element Null(){ return Element(JSON_NULL); }
     inline Element Double(double d){ return Element(d); }
-    inline Element String(std::string s){ return Element(s); }
-    inline Element Array(const std::vector<Element> & v){ return Element(Element::data_t(v)); }
-    inline Element Array(std::vector<Element> && v){ return Element(Element::data_t(std::move(v))); }
-    inline Element Object(const std::map<std::string,Element> & m){ return Element(Element::data_t(m)); }
-    inline Element Object(std::map<std::string,Element> && m){ return Element(Element::data_t(std::move(m))); }
+    inline Element String(std::string s){ return Element(std::move(s)); }
+    inline Element Array(const std::vector<Element> & v){ Element e; e.data.emplace<std::vector<Element>>(v); return e; }
+    inline Element Array(std::vector<Element> && v){ Element e; e.data.emplace<std::vector<Element>>(std::move(v)); return e; }
+    inline Element Object(const Element::object_t & m){ Element e; e.data.emplace<Element::object_t>(m); return e; }
+    inline Element Object(Element::object_t && m){ Element e; e.data.emplace<Element::object_t>(std::move(m)); return e; }
+    
+    //limits for untrusted input, exceeding any of them throws std::runtime_error
+    struct ParseOptions {
+        size_t max_depth=1024;//nesting of arrays and objects
+        size_t max_size=SIZE_MAX;//bytes in the whole document
+        size_t max_string_length=SIZE_MAX;//bytes in a decoded string or key
+        size_t max_members=SIZE_MAX;//elements in one array or members in one object
+        bool strict_strings=false;//RFC 8259 strings: invalid UTF-8, raw control characters, unpaired surrogates and escapes other than \" \\ \/ \b \f \n \r \t \uXXXX are rejected
+    };
+    
+    //uses the default ParseOptions, so documents nested deeper than 1024 levels are rejected
+    Element parse(std::string_view data);
+    Element parse(std::string_view data,const ParseOptions &options);
     
-    Element parse(const std::string &data);
+    //SAX-style interface, receives the structure of a document as it is parsed, without building a tree
+    //string_view arguments are only valid for the duration of the call, strings without escapes are passed as views into the parsed data
+    class Handler {
+        public:
+            virtual ~Handler() = default;
+            
+            virtual void on_object_start() {}
+            virtual void on_key(std::string_view key) {}
+            virtual void on_object_end() {}
+            
+            virtual void on_array_start() {}
+            virtual void on_array_end() {}
+            
+            virtual void on_string(std::string_view s) {}
+            virtual void on_int(int64_t i) {}
+            virtual void on_double(double d) {}
+            virtual void on_literal(JSON_Literal l) {}
+    };
+    
+    //parse a document, reporting it to the handler instead of building an Element tree
+    void parse(std::string_view data,Handler &h);
+    void parse(std::string_view data,Handler &h,const ParseOptions &options);
+    
+    //handler that builds an Element tree, used by parse(std::string_view)
+    class ElementBuilder final : public Handler {
+        public:
+            void on_object_start() override;
+            void on_key(std::string_view key) override;
+            void on_object_end() override;
+            
+            void on_array_start() override;
+            void on_array_end() override;
+            
+            void on_string(std::string_view s) override;
+            void on_int(int64_t i) override;
+            void on_double(double d) override;
+            void on_literal(JSON_Literal l) override;
+            
+            //true once a complete top-level value has been built
+            inline bool done() const { return result.has_value(); }
+            
+            //moves out the completed value and resets the builder, throws std::runtime_error if the value isn't complete
+            Element take();
+            
+        private:
+            std::vector<Element> stack;//containers still being built
+            std::vector<std::string> keys;//keys waiting for their values, one per open object
+            std::optional<Element> result;
+            
+            void add(Element &&e);
+    };
     
 }
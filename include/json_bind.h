@@ -0,0 +1,366 @@
+#pragma once
+
+#include "json.h"
+#include <array>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace JSON {
+    
+    //pull parser over a document, reads one value at a time without building Elements, same grammar and error messages as parse
+    //objects are read with begin_object() and then next_member() until it returns false, arrays with begin_array() and next_element()
+    class Reader {
+        public:
+            enum type_t {
+                OBJECT,
+                ARRAY,
+                STRING,
+                NUMBER,
+                BOOLEAN,
+                NULL_LITERAL,
+            };
+            
+            //options apply as they do to parse, the depth limit also bounds the recursion of Binder::read
+            explicit Reader(std::string_view data,const ParseOptions &options=ParseOptions());
+            
+            //type of the next value, throws std::runtime_error at EOF or if there is no valid value
+            type_t peek();
+            
+            void begin_object();
+            //reads the next key and the ':' after it, returns false (and consumes the '}') at the end of the object, the key is only valid until the next read
+            bool next_member(std::string_view &key);
+            
+            void begin_array();
+            //returns false (and consumes the ']') at the end of the array
+            bool next_element();
+            
+            //all of these throw std::runtime_error if the next value has a different type
+            std::string_view get_string();//only valid until the next read
+            int64_t get_int();//doubles aren't accepted
+            uint64_t get_uint();//same as get_int for unsigned values, including the ones above INT64_MAX
+            double get_double();//integers are accepted
+            bool get_bool();
+            bool get_null();//consumes the value and returns true if it's null, otherwise leaves it and returns false
+            
+            //skips the next value, validating it
+            void skip();
+            
+            //reads the next value as an Element
+            Element get_element();
+            
+            inline size_t position() const { return i; }
+            
+            //throws a std::runtime_error saying what was expected at the current position
+            [[noreturn]] void type_error(const char * expected);
+        
+        private:
+            std::string_view data;
+            size_t i=0;
+            ParseOptions options;
+            std::string scratch;//decoded strings with escapes
+            std::vector<size_t> members;//per open container, number of members or elements read so far
+            
+            void open(char c,const char * expected);
+            bool next(char close);
+            std::string_view read_string();
+    };
+    
+    //field list of a bound type, either generated by JSON_FIELDS inside the type, or specialized for types that can't be modified:
+    //template<> struct JSON::Fields<Point> {
+    //    static constexpr std::string_view names="x,y";//comma separated keys, in the same order as tie()
+    //    static auto tie(Point &p){ return std::tie(p.x,p.y); }
+    //    static auto tie(const Point &p){ return std::tie(p.x,p.y); }
+    //};
+    template<typename T,typename=void>
+    struct Fields {
+    };
+    
+    //declares the listed members as the type's JSON fields, keys are the member names
+    #define JSON_FIELDS(...) \
+        static constexpr std::string_view json_field_names=#__VA_ARGS__; \
+        inline auto json_tie(){ return std::tie(__VA_ARGS__); } \
+        inline auto json_tie() const { return std::tie(__VA_ARGS__); }
+    
+    template<typename T>
+    struct Fields<T,std::void_t<decltype(T::json_field_names)>> {
+        static constexpr std::string_view names=T::json_field_names;
+        static inline auto tie(T &v){ return v.json_tie(); }
+        static inline auto tie(const T &v){ return v.json_tie(); }
+    };
+    
+    template<typename T,typename=void>
+    struct is_bound : std::false_type {
+    };
+    
+    template<typename T>
+    struct is_bound<T,std::void_t<decltype(Fields<T>::names)>> : std::true_type {
+    };
+    
+    namespace bind_detail {
+        
+        void write_string(std::string &out,std::string_view s);
+        void write_int(std::string &out,int64_t i);
+        void write_uint(std::string &out,uint64_t u);
+        void write_double(std::string &out,double d);
+        
+        constexpr uint64_t fnv1a(std::string_view s){
+            uint64_t h=14695981039346656037ull;
+            for(char c:s){
+                h^=static_cast<uint8_t>(c);
+                h*=1099511628211ull;
+            }
+            return h;
+        }
+        
+        constexpr bool is_space(char c){
+            return c==' '||c=='\t'||c=='\n'||c=='\r';
+        }
+        
+        constexpr std::string_view trim(std::string_view s){
+            while(!s.empty()&&is_space(s.front()))s.remove_prefix(1);
+            while(!s.empty()&&is_space(s.back()))s.remove_suffix(1);
+            return s;
+        }
+        
+        constexpr size_t count_names(std::string_view s){
+            size_t n=1;
+            for(char c:s){
+                if(c==',')n++;
+            }
+            return n;
+        }
+        
+        template<size_t N>
+        constexpr std::array<std::string_view,N> split_names(std::string_view s){
+            std::array<std::string_view,N> names{};
+            for(size_t j=0;j<N;j++){
+                size_t comma=s.find(',');
+                names[j]=trim(s.substr(0,comma));
+                s=comma==std::string_view::npos?std::string_view():s.substr(comma+1);
+            }
+            return names;
+        }
+        
+        //keys and their hashes, computed at compile time
+        template<typename T>
+        struct field_table {
+            using tie_t = decltype(Fields<T>::tie(std::declval<T&>()));
+            static constexpr size_t size=std::tuple_size_v<tie_t>;
+            static_assert(count_names(Fields<T>::names)==size,"JSON::Fields names and tie() don't have the same number of fields");
+            static constexpr std::array<std::string_view,size> names=split_names<size>(Fields<T>::names);
+            
+            static constexpr std::array<uint64_t,size> make_hashes(){
+                std::array<uint64_t,size> h{};
+                for(size_t j=0;j<size;j++)h[j]=fnv1a(names[j]);
+                return h;
+            }
+            
+            static constexpr std::array<uint64_t,size> hashes=make_hashes();
+            
+            //index of the field with that key, or size if there is none
+            static inline size_t find(std::string_view key){
+                uint64_t h=fnv1a(key);
+                for(size_t j=0;j<size;j++){
+                    if(hashes[j]==h&&names[j]==key)return j;
+                }
+                return size;
+            }
+        };
+        
+    }
+    
+    //reads and writes values of type T, specialized for bound types, arithmetic types, strings, Element and the standard containers
+    template<typename T,typename=void>
+    struct Binder {
+        static_assert(sizeof(T)==0,"type has no JSON binding, add JSON_FIELDS to it or specialize JSON::Fields");
+    };
+    
+    template<>
+    struct Binder<bool> {
+        static inline void read(Reader &r,bool &v){ v=r.get_bool(); }
+        static inline void write(std::string &out,bool v){ out+=v?"true":"false"; }
+    };
+    
+    template<typename T>
+    struct Binder<T,std::enable_if_t<std::is_integral_v<T>&&!std::is_same_v<T,bool>>> {
+        static void read(Reader &r,T &v){
+            if constexpr(std::is_signed_v<T>){
+                int64_t i=r.get_int();
+                if(i<std::numeric_limits<T>::min()||i>std::numeric_limits<T>::max()) throw std::runtime_error("Int "+std::to_string(i)+" out of range at pos "+std::to_string(r.position()));
+                v=static_cast<T>(i);
+            }else{
+                uint64_t u=r.get_uint();
+                if(u>std::numeric_limits<T>::max()) throw std::runtime_error("Int "+std::to_string(u)+" out of range at pos "+std::to_string(r.position()));
+                v=static_cast<T>(u);
+            }
+        }
+        
+        static inline void write(std::string &out,T v){
+            if constexpr(std::is_signed_v<T>){
+                bind_detail::write_int(out,static_cast<int64_t>(v));
+            }else{
+                bind_detail::write_uint(out,static_cast<uint64_t>(v));
+            }
+        }
+    };
+    
+    template<typename T>
+    struct Binder<T,std::enable_if_t<std::is_floating_point_v<T>>> {
+        static inline void read(Reader &r,T &v){ v=static_cast<T>(r.get_double()); }
+        static inline void write(std::string &out,T v){ bind_detail::write_double(out,static_cast<double>(v)); }
+    };
+    
+    template<>
+    struct Binder<std::string> {
+        static inline void read(Reader &r,std::string &v){ v=r.get_string(); }
+        static inline void write(std::string &out,const std::string &v){ bind_detail::write_string(out,v); }
+    };
+    
+    template<>
+    struct Binder<Element> {
+        static inline void read(Reader &r,Element &v){ v=r.get_element(); }
+        static inline void write(std::string &out,const Element &v){ v.to_json_min(out); }
+    };
+    
+    template<typename T>
+    struct Binder<std::optional<T>> {
+        static void read(Reader &r,std::optional<T> &v){
+            if(r.get_null()){
+                v.reset();
+            }else{
+                if(!v)v.emplace();
+                Binder<T>::read(r,*v);
+            }
+        }
+        
+        static void write(std::string &out,const std::optional<T> &v){
+            if(v){
+                Binder<T>::write(out,*v);
+            }else{
+                out+="null";
+            }
+        }
+    };
+    
+    template<typename T>
+    struct Binder<std::vector<T>> {
+        static void read(Reader &r,std::vector<T> &v){
+            v.clear();
+            r.begin_array();
+            while(r.next_element()){
+                v.emplace_back();
+                Binder<T>::read(r,v.back());
+            }
+        }
+        
+        static void write(std::string &out,const std::vector<T> &v){
+            out+='[';
+            for(size_t j=0;j<v.size();j++){
+                if(j)out+=',';
+                Binder<T>::write(out,v[j]);
+            }
+            out+=']';
+        }
+    };
+    
+    //first one wins for duplicate keys, same as parse
+    template<typename T>
+    struct Binder<std::map<std::string,T>> {
+        static void read(Reader &r,std::map<std::string,T> &v){
+            v.clear();
+            r.begin_object();
+            std::string_view key;
+            while(r.next_member(key)){
+                auto res=v.try_emplace(std::string(key));
+                if(res.second){
+                    Binder<T>::read(r,res.first->second);
+                }else{
+                    r.skip();
+                }
+            }
+        }
+        
+        static void write(std::string &out,const std::map<std::string,T> &v){
+            out+='{';
+            bool first=true;
+            for(const auto &c:v){
+                if(!first)out+=',';
+                first=false;
+                bind_detail::write_string(out,c.first);
+                out+=':';
+                Binder<T>::write(out,c.second);
+            }
+            out+='}';
+        }
+    };
+    
+    //unknown keys are skipped, missing keys leave the member unchanged, first one wins for duplicate keys
+    template<typename T>
+    struct Binder<T,std::enable_if_t<is_bound<T>::value>> {
+        using table = bind_detail::field_table<T>;
+        
+        template<typename Tuple,size_t... I>
+        static inline void read_field(Reader &r,Tuple &&fields,size_t index,std::index_sequence<I...>){
+            ((index==I?Binder<std::decay_t<std::tuple_element_t<I,std::decay_t<Tuple>>>>::read(r,std::get<I>(fields)):void()),...);
+        }
+        
+        template<typename Tuple,size_t... I>
+        static inline void write_fields(std::string &out,const Tuple &fields,std::index_sequence<I...>){
+            ((out+=I?",":"",bind_detail::write_string(out,table::names[I]),out+=':',Binder<std::decay_t<std::tuple_element_t<I,Tuple>>>::write(out,std::get<I>(fields))),...);
+        }
+        
+        static void read(Reader &r,T &v){
+            auto fields=Fields<T>::tie(v);
+            std::array<bool,table::size> seen{};
+            r.begin_object();
+            std::string_view key;
+            while(r.next_member(key)){
+                size_t index=table::find(key);
+                if(index==table::size||seen[index]){
+                    r.skip();
+                    continue;
+                }
+                seen[index]=true;
+                read_field(r,fields,index,std::make_index_sequence<table::size>());
+            }
+        }
+        
+        static void write(std::string &out,const T &v){
+            out+='{';
+            write_fields(out,Fields<T>::tie(v),std::make_index_sequence<table::size>());
+            out+='}';
+        }
+    };
+    
+    //parses data straight into v, without building Elements, throws std::runtime_error for invalid documents and type mismatches
+    //uses the default ParseOptions, so documents nested deeper than 1024 levels are rejected
+    template<typename T>
+    void parse_into(std::string_view data,T &v,const ParseOptions &options=ParseOptions()){
+        Reader r(data,options);
+        Binder<T>::read(r,v);
+    }
+    
+    template<typename T>
+    T parse_into(std::string_view data,const ParseOptions &options=ParseOptions()){
+        T v{};
+        parse_into(data,v,options);
+        return v;
+    }
+    
+    //compact JSON for a bound value, same format as to_json_min
+    template<typename T>
+    void to_json(const T &v,std::string &out){
+        Binder<T>::write(out,v);
+    }
+    
+    template<typename T>
+    std::string to_json(const T &v){
+        std::string out;
+        Binder<T>::write(out,v);
+        return out;
+    }
+
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "json.h"
+#include <memory>
+#include <unordered_set>
+
+namespace JSON {
+    
+    //monotonic allocator, memory is only released all at once when the arena is destroyed
+    class Arena {
+        public:
+            Arena() = default;
+            Arena(const Arena &) = delete;
+            Arena(Arena &&) = default;
+            Arena& operator=(const Arena &) = delete;
+            Arena& operator=(Arena &&) = default;
+            
+            void * allocate(size_t size,size_t align);
+            
+            template<typename T>
+            inline T * allocate_array(size_t n){ return static_cast<T*>(allocate(sizeof(T)*n,alignof(T))); }
+            
+            //total bytes reserved from the heap
+            inline size_t capacity() const { return reserved; }
+        
+        private:
+            std::vector<std::unique_ptr<char[]>> blocks;
+            char * cur=nullptr;
+            size_t left=0;
+            size_t next_block=4096;
+            size_t reserved=0;
+    };
+    
+    class Value;
+    struct Member;
+    
+    class ArrayView {
+        public:
+            inline ArrayView(const Value * p,size_t n) : ptr(p), len(n) {}
+            
+            inline const Value * begin() const { return ptr; }
+            inline const Value * end() const;
+            inline size_t size() const { return len; }
+            inline bool empty() const { return len==0; }
+            inline const Value & operator[](size_t i) const;
+            const Value & at(size_t i) const;//throws std::out_of_range
+        
+        private:
+            const Value * ptr;
+            size_t len;
+    };
+    
+    //members are in the same order as Element's objects: sorted by key, or in document order with JSON_ORDERED_OBJECTS
+    //with JSON_ORDERED_OBJECTS the member table is followed by the members' positions sorted by key, which find() searches
+    class ObjectView {
+        public:
+            inline ObjectView(const Member * p,size_t n) : ptr(p), len(n) {}
+            
+            inline const Member * begin() const { return ptr; }
+            inline const Member * end() const;
+            inline size_t size() const { return len; }
+            inline bool empty() const { return len==0; }
+            
+            const Member * find(std::string_view key) const;//returns end() if not found
+            inline size_t count(std::string_view key) const { return find(key)!=end(); }
+            const Value & at(std::string_view key) const;//throws std::out_of_range
+        
+        private:
+            const Member * ptr;
+            size_t len;
+    };
+    
+    //read-only node of a Document, stored in the document's arena, trivially destructible
+    class Value {
+        public:
+            enum type_t : uint8_t {
+                INT,
+                DOUBLE,
+                STRING,
+                ARRAY,
+                OBJECT,
+                LITERAL,
+            };
+            
+            inline Value() : t(LITERAL) { v.l=JSON_NULL; }
+            
+            inline type_t type() const { return t; }
+            
+            //helper access methods, throw std::bad_variant_access if trying to access wrong types, same as Element
+            inline int64_t get_int() const { return t==INT?v.i:throw std::bad_variant_access(); }
+            inline double get_double() const { return t==DOUBLE?v.d:throw std::bad_variant_access(); }
+            inline std::string_view get_str() const { return t==STRING?std::string_view(v.str.ptr,v.str.len):throw std::bad_variant_access(); }
+            inline ArrayView get_arr() const { return t==ARRAY?ArrayView(v.arr.ptr,v.arr.len):throw std::bad_variant_access(); }
+            inline ObjectView get_obj() const { return t==OBJECT?ObjectView(v.obj.ptr,v.obj.len):throw std::bad_variant_access(); }
+            inline JSON_Literal get_lit() const { return t==LITERAL?v.l:throw std::bad_variant_access(); }
+            inline bool get_bool() const { return t==LITERAL&&v.l!=JSON_NULL?v.l==JSON_TRUE:throw std::bad_variant_access(); }
+            
+            //helper type check methods
+            inline bool is_int() const { return t==INT; }
+            inline bool is_double() const { return t==DOUBLE; }
+            inline bool is_str() const { return t==STRING; }
+            inline bool is_arr() const { return t==ARRAY; }
+            inline bool is_obj() const { return t==OBJECT; }
+            inline bool is_lit() const { return t==LITERAL; }
+            inline bool is_bool() const { return t==LITERAL&&v.l!=JSON_NULL; }
+            inline bool is_null() const { return t==LITERAL&&v.l==JSON_NULL; }
+            
+            //deep copy into a regular Element tree
+            Element to_element() const;
+        
+        private:
+            friend class DocumentBuilder;
+            
+            type_t t;
+            union {
+                int64_t i;
+                double d;
+                JSON_Literal l;
+                struct {
+                    const char * ptr;
+                    size_t len;
+                } str;
+                struct {
+                    const Value * ptr;
+                    size_t len;
+                } arr;
+                struct {
+                    const Member * ptr;
+                    size_t len;
+                } obj;
+            } v;
+    };
+    
+    struct Member {
+        std::string_view first;//key, interned, equal keys in a document share storage
+        Value second;
+    };
+    
+    inline const Value * ArrayView::end() const { return ptr+len; }
+    inline const Value & ArrayView::operator[](size_t i) const { return ptr[i]; }
+    inline const Member * ObjectView::end() const { return ptr+len; }
+    
+    //parsed document whose nodes, strings and member tables all live in a single arena
+    //destroying it frees everything at once, Values are only valid while the Document is alive
+    class Document {
+        public:
+            Document() = default;
+            Document(const Document &) = delete;
+            Document(Document &&) = default;
+            Document& operator=(const Document &) = delete;
+            Document& operator=(Document &&) = default;
+            
+            //options apply as they do to JSON::parse
+            static Document parse(std::string_view data,const ParseOptions &options=ParseOptions());
+            
+            //zero-copy parse, strings and keys without escapes are views into data, which must outlive the document
+            //only strings with escape sequences are decoded into the arena
+            static Document parse_view(std::string_view data,const ParseOptions &options=ParseOptions());
+            
+            inline const Value & root() const { return root_value; }
+            
+            //bytes reserved by the arena
+            inline size_t memory_used() const { return arena.capacity(); }
+            
+            //number of distinct object keys
+            inline size_t key_count() const { return keys.size(); }
+        
+        private:
+            friend class DocumentBuilder;
+            
+            Arena arena;
+            std::unordered_set<std::string_view> keys;
+            Value root_value;
+    };
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "json.h"
+
+namespace JSON {
+    
+    //read-only contents of a file, memory mapped for regular files, read into a buffer for pipes and other streams
+    class MappedFile {
+        public:
+            //throws std::runtime_error if the file can't be opened or read
+            explicit MappedFile(const std::string &path);
+            ~MappedFile();
+            
+            MappedFile(MappedFile &&other) noexcept;
+            MappedFile& operator=(MappedFile &&other) noexcept;
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+            
+            inline std::string_view data() const { return std::string_view(ptr,len); }
+            inline size_t size() const { return len; }
+            
+            //true if data() points into a mapping of the file rather than a copy
+            inline bool mapped() const { return map_len!=0; }
+            
+            //bytes copied with read(), 0 if the file is mapped
+            inline size_t bytes_read() const { return mapped()?0:len; }
+            
+            //pages of the data that are currently in memory, for a mapping that includes pages that were already in the page cache, whether they were read or not
+            size_t resident_pages() const;
+            
+            static size_t page_size();
+        
+        private:
+            const char * ptr=nullptr;
+            size_t len=0;
+            size_t map_len=0;//length of the mapping, 0 if not mapped
+            std::string buffer;//contents if not mapped
+            
+            void release();
+    };
+    
+    struct FileStats {
+        size_t file_size=0;
+        size_t bytes_read=0;//bytes copied into memory with read(), 0 when the file was mapped
+        size_t pages_resident=0;//pages of the data in memory after parsing, page cache residency rather than pages the parse read
+        size_t minor_faults=0;//page faults of the calling thread while opening and parsing the file, including ones for the Element tree's allocations
+        size_t major_faults=0;//the ones that had to wait for the disk
+        bool mapped=false;
+    };
+    
+    //parses a file directly from a memory mapping, without copying it into a std::string first, same errors as parse(std::string_view)
+    //stats, if not null, is filled in after a successful parse
+    Element parse_file(const std::string &path,FileStats * stats=nullptr);
+
+}
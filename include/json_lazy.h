@@ -0,0 +1,124 @@
+#pragma once
+
+#include "json.h"
+#include <iterator>
+
+namespace JSON {
+    
+    class LazyDocument;
+    
+    //handle to a value inside a LazyDocument, nothing is parsed until get() (or one of the get_* helpers) is called
+    //only valid while the LazyDocument it came from is alive and not moved
+    class LazyValue {
+        public:
+            class iterator;
+            
+            //type checks, only look at the first character of the value
+            bool is_num() const;
+            bool is_str() const;
+            bool is_arr() const;
+            bool is_obj() const;
+            bool is_lit() const;
+            
+            //member lookup, first occurrence wins for duplicate keys, same as Element, throws std::bad_variant_access if not an object
+            bool contains(std::string_view key) const;
+            LazyValue operator[](std::string_view key) const;//throws std::out_of_range if there is no such key
+            
+            //element lookup, throws std::bad_variant_access if not an array and std::out_of_range if the index is past the end
+            LazyValue operator[](size_t index) const;
+            
+            //number of elements or members, throws std::bad_variant_access if not an array or object
+            //counts raw members, so duplicate keys are counted every time they appear (unlike get().get_obj().size())
+            size_t size() const;
+            
+            //iterates the elements of an array or the values of an object, throws std::bad_variant_access otherwise
+            //members are visited in document order and duplicate keys are visited every time, while lookup and get() keep only the first one
+            iterator begin() const;
+            iterator end() const;
+            
+            //key of a value reached by iterating an object, throws std::logic_error otherwise
+            std::string key() const;
+            
+            //position of the value in the source data
+            size_t position() const;
+            
+            //materialize the value (and everything in it) as an Element
+            Element get() const;
+            
+            inline int64_t get_int() const { return get().get_int(); }
+            inline double get_double() const { return get().get_double(); }
+            inline std::string get_str() const { return std::move(get().get_str()); }
+            inline bool get_bool() const { return get().get_bool(); }
+            inline bool is_null() const { return is_lit()&&get().is_null(); }
+        
+        private:
+            friend class LazyDocument;
+            
+            static constexpr size_t npos=-1;
+            
+            inline LazyValue(const LazyDocument * d,size_t i,size_t k=npos) : doc(d), idx(i), key_idx(k) {}
+            
+            const LazyDocument * doc;
+            size_t idx;//tape entry of the value
+            size_t key_idx;//tape entry of its key, if it's an object member
+            
+            char first() const;
+            void require(char c) const;
+    };
+    
+    class LazyValue::iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = LazyValue;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = LazyValue;
+            
+            LazyValue operator*() const;
+            iterator& operator++();
+            inline iterator operator++(int){ iterator it=*this; ++*this; return it; }
+            inline bool operator==(const iterator &o) const { return idx==o.idx; }
+            inline bool operator!=(const iterator &o) const { return idx!=o.idx; }
+        
+        private:
+            friend class LazyValue;
+            
+            inline iterator(const LazyDocument * d,size_t i,bool obj) : doc(d), idx(i), object(obj) {}
+            
+            const LazyDocument * doc;
+            size_t idx;//tape entry of the current element, or of the current member's key
+            bool object;
+    };
+    
+    //structural index (tape) over a document, built in a single validating pass that records where every value starts and where its subtree ends
+    //values are only parsed when they're accessed, and unneeded subtrees are skipped in O(1)
+    //the data isn't copied, it must outlive the LazyDocument
+    class LazyDocument {
+        public:
+            //indexes the document, throws std::runtime_error for invalid documents, with the same messages as JSON::parse
+            //options apply to the whole document while it's indexed, and again when values are materialized
+            explicit LazyDocument(std::string_view data,const ParseOptions &options=ParseOptions());
+            
+            inline LazyValue root() const { return LazyValue(this,0); }
+            
+            //number of tape entries (values and keys)
+            inline size_t tape_size() const { return tape.size(); }
+        
+        private:
+            friend class LazyValue;
+            friend class TapeBuilder;
+            
+            struct entry {
+                size_t pos;//position of the first character of the value or key
+                size_t next;//tape entry right after the value's subtree
+            };
+            
+            std::string_view data;
+            ParseOptions options;
+            std::vector<entry> tape;
+            
+            bool key_equals(size_t idx,std::string_view key) const;
+            size_t find(size_t idx,std::string_view key) const;
+    };
+
+}
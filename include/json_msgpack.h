@@ -0,0 +1,20 @@
+#pragma once
+
+#include "json.h"
+
+namespace JSON {
+    
+    //MessagePack encoding of an Element, integers use the smallest int format that holds them, doubles are always float 64, literals map to nil/true/false
+    //throws std::length_error for strings, arrays or objects with more than 2^32-1 bytes or members, which MessagePack can't represent
+    std::string to_msgpack(const Element &e);
+    void to_msgpack(const Element &e,std::string &out);//appends to out
+    
+    //decodes a single MessagePack value, throws std::runtime_error for truncated or invalid data, non-string map keys, ext types, or trailing bytes
+    //bin is read as a string, float 32 as a double, and unsigned integers above INT64_MAX are promoted to double, same as the text parser
+    //for duplicate map keys the first one wins, same as parse
+    //uses the default ParseOptions, so values nested deeper than 1024 levels are rejected
+    Element from_msgpack(std::string_view data);
+    //max_depth, max_size, max_members and max_string_length (bytes, for str, bin and keys) apply as they do to parse, strict_strings checks that str values and keys are valid UTF-8
+    Element from_msgpack(std::string_view data,const ParseOptions &options);
+
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "json.h"
+
+namespace JSON {
+    
+    //one document from a newline-delimited batch
+    struct Record {
+        Element value;//null if the record failed to parse
+        std::string error;//empty if the record parsed successfully
+        size_t line;//1-based line the record starts on
+        size_t offset;//position of the record in the batch
+        
+        inline bool ok() const { return error.empty(); }
+    };
+    
+    struct BatchOptions {
+        size_t threads=0;//0 for one per core
+        size_t chunk_size=256*1024;//approximate bytes per work unit, chunks always end at a newline
+        ParseOptions parse_options;//limits for each record, max_size applies to each line, a record that exceeds one gets that error
+    };
+    
+    //parses newline-delimited JSON (JSON Lines), lines are parsed in parallel and the records are returned in input order
+    //blank lines are skipped, several documents on the same line are returned as separate records
+    //a record that fails to parse gets the same error message JSON::parse would throw, and parsing continues on the next line
+    std::vector<Record> parse_lines(std::string_view data,const BatchOptions &options=BatchOptions());
+
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <tuple>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace JSON {
+    
+    //flat map with string keys that keeps insertion order
+    //members are stored contiguously in a vector, objects with more than a handful of members also get an open-addressing hash index over them
+    //iterators and references are invalidated by insertion and erasure, same as std::vector
+    template<typename T>
+    class ObjectMap {
+        public:
+            using key_type = std::string;
+            using mapped_type = T;
+            using value_type = std::pair<std::string,T>;
+            using iterator = typename std::vector<value_type>::iterator;
+            using const_iterator = typename std::vector<value_type>::const_iterator;
+            
+            ObjectMap() = default;
+            
+            inline ObjectMap(std::initializer_list<value_type> l){
+                reserve(l.size());
+                for(const value_type &v:l)insert(v);
+            }
+            
+            inline iterator begin() { return entries.begin(); }
+            inline iterator end() { return entries.end(); }
+            inline const_iterator begin() const { return entries.begin(); }
+            inline const_iterator end() const { return entries.end(); }
+            inline const_iterator cbegin() const { return entries.begin(); }
+            inline const_iterator cend() const { return entries.end(); }
+            
+            inline size_t size() const { return entries.size(); }
+            inline bool empty() const { return entries.empty(); }
+            
+            inline void reserve(size_t n){
+                entries.reserve(n);
+                if(n>linear_limit&&n*2>slots.size())rehash(n);
+            }
+            
+            inline void clear(){
+                entries.clear();
+                slots.clear();
+            }
+            
+            inline iterator find(std::string_view key){
+                size_t i=lookup(key);
+                return i==npos?end():begin()+i;
+            }
+            
+            inline const_iterator find(std::string_view key) const {
+                size_t i=lookup(key);
+                return i==npos?end():begin()+i;
+            }
+            
+            inline size_t count(std::string_view key) const { return lookup(key)!=npos; }
+            
+            inline T& at(std::string_view key){
+                size_t i=lookup(key);
+                if(i==npos) throw std::out_of_range("ObjectMap::at");
+                return entries[i].second;
+            }
+            
+            inline const T& at(std::string_view key) const {
+                size_t i=lookup(key);
+                if(i==npos) throw std::out_of_range("ObjectMap::at");
+                return entries[i].second;
+            }
+            
+            inline T& operator[](std::string key){
+                return try_emplace(std::move(key)).first->second;
+            }
+            
+            //does nothing if the key is already present, same as std::map
+            template<typename... Args>
+            std::pair<iterator,bool> try_emplace(std::string key,Args&&... args){
+                size_t i=lookup(key);
+                if(i!=npos) return {begin()+i,false};
+                entries.emplace_back(std::piecewise_construct,std::forward_as_tuple(std::move(key)),std::forward_as_tuple(std::forward<Args>(args)...));
+                added();
+                return {end()-1,true};
+            }
+            
+            //the hint is ignored, new members are always appended, only here for compatibility with std::map
+            template<typename... Args>
+            inline iterator try_emplace(const_iterator,std::string key,Args&&... args){
+                return try_emplace(std::move(key),std::forward<Args>(args)...).first;
+            }
+            
+            template<typename... Args>
+            inline std::pair<iterator,bool> emplace(std::string key,Args&&... args){
+                return try_emplace(std::move(key),std::forward<Args>(args)...);
+            }
+            
+            inline std::pair<iterator,bool> insert(value_type &&v){
+                return try_emplace(std::move(v.first),std::move(v.second));
+            }
+            
+            inline std::pair<iterator,bool> insert(const value_type &v){
+                return try_emplace(v.first,v.second);
+            }
+            
+            //keeps the order of the remaining members, O(n)
+            size_t erase(std::string_view key){
+                size_t i=lookup(key);
+                if(i==npos) return 0;
+                entries.erase(begin()+i);
+                if(entries.size()>linear_limit){
+                    rehash(entries.size());
+                }else{
+                    slots.clear();
+                }
+                return 1;
+            }
+        
+        private:
+            static constexpr size_t linear_limit=8;//objects up to this size are searched linearly, without an index
+            static constexpr size_t npos=-1;
+            
+            std::vector<value_type> entries;
+            std::vector<uint32_t> slots;//entry index+1, 0 for empty slots, size is a power of two at least twice the number of entries
+            
+            static inline size_t hash(std::string_view key){
+                return std::hash<std::string_view>()(key);
+            }
+            
+            size_t lookup(std::string_view key) const {
+                if(slots.empty()){
+                    for(size_t i=0;i<entries.size();i++){
+                        if(entries[i].first==key) return i;
+                    }
+                    return npos;
+                }
+                size_t mask=slots.size()-1;
+                for(size_t h=hash(key)&mask;slots[h];h=(h+1)&mask){
+                    size_t i=slots[h]-1;
+                    if(entries[i].first==key) return i;
+                }
+                return npos;
+            }
+            
+            void place(size_t i){
+                size_t mask=slots.size()-1;
+                size_t h=hash(entries[i].first)&mask;
+                while(slots[h])h=(h+1)&mask;
+                slots[h]=i+1;
+            }
+            
+            void rehash(size_t n){
+                size_t cap=16;
+                while(cap<n*2)cap*=2;
+                slots.assign(cap,0);
+                for(size_t i=0;i<entries.size();i++)place(i);
+            }
+            
+            void added(){
+                if(slots.empty()&&entries.size()<=linear_limit)return;
+                if(entries.size()*2>slots.size()){
+                    rehash(entries.size());
+                }else{
+                    place(entries.size()-1);
+                }
+            }
+    };
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "json.h"
+
+namespace JSON {
+    
+    struct SerializeOptions {
+        size_t threads=0;//0 for one per core
+        size_t chunk_size=256*1024;//approximate output bytes per work unit, smaller documents are written on the calling thread
+        bool ascii_only=false;//same as the ascii_only argument of Element::to_json
+    };
+    
+    //same output as Element::to_json, byte for byte, large arrays and objects are split into runs of elements that are written on several threads and then joined
+    std::string to_json_parallel(const Element &e,bool trailing_quote=true,size_t depth=0,const SerializeOptions &options=SerializeOptions());
+    void to_json_parallel(const Element &e,std::string &out,bool trailing_quote=true,size_t depth=0,const SerializeOptions &options=SerializeOptions());//appends to out
+    
+    //same output as Element::to_json_min
+    std::string to_json_min_parallel(const Element &e,const SerializeOptions &options=SerializeOptions());
+    void to_json_min_parallel(const Element &e,std::string &out,const SerializeOptions &options=SerializeOptions());//appends to out
+    
+    struct ParallelParseOptions {
+        size_t threads=0;//0 for one per core
+        size_t chunk_size=1024*1024;//input bytes per work unit, documents smaller than two chunks are parsed on the calling thread
+    };
+    
+    //same result as parse(data,options), the elements of the container holding most of the document are parsed on several threads
+    //a first pass over chunks of the input tracks strings and comments to find the top-level separators, invalid documents are parsed again sequentially so the exception is the same as parse's
+    Element parse_parallel(std::string_view data,const ParseOptions &options=ParseOptions(),const ParallelParseOptions &parallel=ParallelParseOptions());
+
+}
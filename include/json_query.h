@@ -0,0 +1,42 @@
+#pragma once
+
+#include "json.h"
+
+namespace JSON {
+    
+    //set of JSON Pointers (RFC 6901) compiled once and run over many documents, without building the full tree
+    //a reference token of "*" matches every element of an array (and a member named "*" of an object)
+    //only the matched values are parsed into Elements, everything else is skipped, and if no pointer has a wildcard the scan stops as soon as all of them have matched
+    class Query {
+        public:
+            //throws std::invalid_argument for a pointer that isn't empty and doesn't start with '/', or has an invalid '~' escape
+            explicit Query(const std::vector<std::string> &pointers);
+            
+            //one vector per pointer, in the order they were given, holding the matches in document order
+            //pointers without a wildcard match at most once, for duplicate keys the first one wins, same as Element
+            //throws std::runtime_error for malformed input, the part of the document after the last match isn't validated
+            std::vector<std::vector<Element>> run(std::string_view data) const;
+            
+            inline size_t size() const { return pointer_count; }
+        
+        private:
+            static constexpr size_t npos=-1;
+            
+            struct node {
+                size_t parent=npos;
+                std::vector<std::pair<std::string,size_t>> keys;//child nodes by member name
+                std::vector<std::pair<size_t,size_t>> indices;//child nodes by array index
+                size_t wildcard=npos;//child node matching every array element
+                std::vector<size_t> targets;//pointers that end at this node
+                size_t fixed=0;//pointers without a wildcard that end in this subtree
+                bool open=false;//some pointer with a wildcard goes through this node, so it's never exhausted
+            };
+            
+            std::vector<node> nodes;//nodes[0] is the root
+            std::vector<bool> repeated;//pointers with a wildcard, which can match more than once
+            size_t pointer_count=0;
+            
+            friend class QueryRunner;
+    };
+
+}
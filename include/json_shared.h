@@ -0,0 +1,111 @@
+#pragma once
+
+#include "json.h"
+#include <memory>
+#include <stdexcept>
+
+namespace JSON {
+    
+    //reference counted, copy-on-write JSON value: copying one shares the whole tree, so a snapshot is a single reference count increment
+    //strings, arrays and objects are nodes shared between copies, the mut_* methods copy a node only if another SharedElement still refers to it,
+    //so changing one member deep in a tree copies just the path down to it (each copy is shallow, the children are shared), and everything else stays shared
+    //a tree can be read from any number of threads, but one SharedElement object still has to be locked if a thread mutates it while others read or copy it
+    class SharedElement {
+        public:
+            #ifdef JSON_ORDERED_OBJECTS
+            using object_t = ObjectMap<SharedElement>;
+            #else
+            using object_t = std::map<std::string,SharedElement,std::less<>>;
+            #endif
+            using array_t = std::vector<SharedElement>;
+            
+            //null
+            inline SharedElement() : data(JSON_NULL) {}
+            
+            inline SharedElement(int i) : data(static_cast<int64_t>(i)) {}
+            inline SharedElement(int64_t i) : data(i) {}
+            inline SharedElement(double d) : data(d) {}
+            inline SharedElement(bool b) : data(b?JSON_TRUE:JSON_FALSE) {}
+            inline SharedElement(std::nullptr_t) : data(JSON_NULL) {}
+            inline SharedElement(JSON_Literal l) : data(l) {}
+            SharedElement(std::string s);
+            SharedElement(array_t a);
+            SharedElement(object_t o);
+            
+            //converts an Element tree, the rvalue version moves strings out of it instead of copying them
+            explicit SharedElement(const Element &e);
+            explicit SharedElement(Element &&e);
+            
+            //deep copy into a regular Element tree
+            Element to_element() const;
+            
+            //helper type check methods
+            inline bool is_int() const { return std::holds_alternative<int64_t>(data); }
+            inline bool is_double() const { return std::holds_alternative<double>(data); }
+            inline bool is_str() const;
+            inline bool is_arr() const;
+            inline bool is_obj() const;
+            inline bool is_lit() const { return std::holds_alternative<JSON_Literal>(data); }
+            inline bool is_bool() const { return is_lit()&&std::get<JSON_Literal>(data)!=JSON_NULL; }
+            inline bool is_null() const { return is_lit()&&std::get<JSON_Literal>(data)==JSON_NULL; }
+            
+            //read-only access, throws std::bad_variant_access if trying to access wrong types, same as Element
+            inline int64_t get_int() const { return std::get<int64_t>(data); }
+            inline double get_double() const { return std::get<double>(data); }
+            inline const std::string& get_str() const;
+            inline const array_t& get_arr() const;
+            inline const object_t& get_obj() const;
+            inline JSON_Literal get_lit() const { return std::get<JSON_Literal>(data); }
+            inline bool get_bool() const { return is_bool()?std::get<JSON_Literal>(data)==JSON_TRUE:throw std::bad_variant_access(); }
+            
+            //array elements and object members, throw std::out_of_range if missing
+            const SharedElement& at(size_t i) const;
+            const SharedElement& at(std::string_view key) const;
+            const SharedElement* find(std::string_view key) const;//nullptr if missing
+            
+            //copy-on-write access, this node is copied first if it's shared, the reference is valid until this SharedElement is copied from and mutated again
+            //throw std::bad_variant_access if trying to access wrong types
+            std::string& mut_str();
+            array_t& mut_arr();
+            object_t& mut_obj();
+            SharedElement& mut_at(size_t i);//throws std::out_of_range
+            SharedElement& mut_at(std::string_view key);//throws std::out_of_range
+            
+            //whether both refer to the same node, always false for ints, doubles and literals, which aren't shared
+            inline bool shares_with(const SharedElement &o) const;
+            
+            //same output as the Element methods with the same names
+            std::string to_json(bool trailing_quote=true,size_t depth=0,bool ascii_only=false) const;
+            void to_json(std::string &out,bool trailing_quote=true,size_t depth=0,bool ascii_only=false) const;
+            std::string to_json_min(bool ascii_only=false) const;
+            void to_json_min(std::string &out,bool ascii_only=false) const;
+        
+        private:
+            struct Node;
+            
+            std::variant<int64_t,double,JSON_Literal,std::shared_ptr<Node>> data;
+            
+            inline const Node * node() const;
+            Node& unique();
+    };
+    
+    struct SharedElement::Node {
+        std::variant<std::string,array_t,object_t> data;
+    };
+    
+    inline const SharedElement::Node * SharedElement::node() const {
+        const std::shared_ptr<Node> * p=std::get_if<std::shared_ptr<Node>>(&data);
+        return p?p->get():nullptr;
+    }
+    
+    inline bool SharedElement::is_str() const { return node()&&std::holds_alternative<std::string>(node()->data); }
+    inline bool SharedElement::is_arr() const { return node()&&std::holds_alternative<array_t>(node()->data); }
+    inline bool SharedElement::is_obj() const { return node()&&std::holds_alternative<object_t>(node()->data); }
+    
+    inline const std::string& SharedElement::get_str() const { return is_str()?std::get<std::string>(node()->data):throw std::bad_variant_access(); }
+    inline const SharedElement::array_t& SharedElement::get_arr() const { return is_arr()?std::get<array_t>(node()->data):throw std::bad_variant_access(); }
+    inline const SharedElement::object_t& SharedElement::get_obj() const { return is_obj()?std::get<object_t>(node()->data):throw std::bad_variant_access(); }
+    
+    inline bool SharedElement::shares_with(const SharedElement &o) const { return node()&&node()==o.node(); }
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "json.h"
+#include <utility>
+
+namespace JSON {
+    
+    //what one parse call did, times are in nanoseconds
+    //only the overloads that take a ParseStats fill it in, they use a separately compiled parser, so the plain parse functions don't pay for any of it
+    struct ParseStats {
+        size_t bytes=0;//consumed, up to the end of the value
+        uint64_t total_ns=0;
+        uint64_t whitespace_ns=0;//skipping whitespace and comments
+        uint64_t string_ns=0;//scanning and decoding strings and keys
+        uint64_t number_ns=0;
+        uint64_t build_ns=0;//handler callbacks, for parse(data) that's building the Element tree
+        size_t ints=0;
+        size_t doubles=0;
+        size_t strings=0;
+        size_t arrays=0;
+        size_t objects=0;
+        size_t literals=0;
+        size_t keys=0;
+        size_t max_depth=0;
+        size_t escapes=0;//escape sequences in strings and keys
+        size_t allocations=0;//heap allocations of the Element tree, estimated from the sizes of its strings, arrays and objects
+        size_t allocated_bytes=0;
+        
+        //name/value pairs for a metrics system, the names are prefix.field
+        std::vector<std::pair<std::string,uint64_t>> counters(const std::string &prefix="json.parse") const;
+        
+        //counters() as "name value" lines
+        std::string dump(const std::string &prefix="json.parse") const;
+    };
+    
+    //same as parse(data,options), filling in stats for this call
+    Element parse(std::string_view data,ParseStats &stats,const ParseOptions &options=ParseOptions());
+    void parse(std::string_view data,Handler &h,ParseStats &stats,const ParseOptions &options=ParseOptions());
+    
+    //what one to_json or to_json_min call did, times are in nanoseconds
+    struct SerializeStats {
+        size_t bytes=0;//written
+        uint64_t total_ns=0;
+        uint64_t string_ns=0;//quoting and escaping strings and keys
+        uint64_t number_ns=0;
+        size_t ints=0;
+        size_t doubles=0;
+        size_t strings=0;
+        size_t arrays=0;
+        size_t objects=0;
+        size_t literals=0;
+        size_t keys=0;
+        size_t max_depth=0;
+        size_t escapes=0;//characters written as escape sequences
+        size_t allocations=0;//times the output buffer had to grow
+        size_t allocated_bytes=0;//sum of the buffer's capacity after each growth
+        
+        std::vector<std::pair<std::string,uint64_t>> counters(const std::string &prefix="json.serialize") const;
+        std::string dump(const std::string &prefix="json.serialize") const;
+    };
+    
+    //same as Element::to_json and Element::to_json_min appending to out, filling in stats for this call
+    void to_json(const Element &e,std::string &out,SerializeStats &stats,bool trailing_quote=true,size_t depth=0,bool ascii_only=false);
+    void to_json_min(const Element &e,std::string &out,SerializeStats &stats,bool ascii_only=false);
+
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "json.h"
+#include <deque>
+
+namespace JSON {
+    
+    //resumable push parser, can be fed the input in arbitrary chunks (ex. as it's read from a socket or pipe)
+    //reports values to the handler as soon as they're read, only keeps the token currently being read in memory
+    //accepts any number of top-level values one after another, so it also works for concatenated/newline-delimited documents
+    //after it throws, the parser is left in an unspecified state and must not be fed anymore
+    //options apply to every top-level value the same way they do to parse, except max_size, the input has no overall size
+    //a string that continues past the end of what was fed is buffered, so it's also rejected once its raw text passes 6 times max_string_length (the longest escape per decoded byte)
+    //numbers are buffered the same way and are rejected past max_number_length characters, literals are matched a byte at a time and never take more than 5
+    class StreamParser {
+        public:
+            static constexpr size_t max_number_length=4096;
+            
+            explicit StreamParser(Handler &h,const ParseOptions &options=ParseOptions());
+            
+            void feed(const char * data,size_t len);
+            inline void feed(std::string_view data){ feed(data.data(),data.size()); }
+            
+            //signals the end of the input, throws std::runtime_error if the input ends in the middle of a value, resets the parser afterwards
+            void finish();
+            
+            //true if the parser isn't in the middle of a top-level value
+            bool idle() const;
+            
+            //number of bytes fed so far
+            inline size_t position() const { return consumed; }
+        
+        private:
+            enum state_t {
+                VALUE,          //expecting a value
+                VALUE_OR_END,   //expecting a value or ']', after '[' or ','
+                ARRAY_SEP,      //expecting ',' or ']'
+                KEY_OR_END,     //expecting a key or '}', after '{' or ','
+                COLON,          //expecting ':'
+                OBJECT_SEP,     //expecting ',' or '}'
+            };
+            
+            enum scan_t {
+                STRUCTURE,      //between tokens
+                STRING,
+                NUMBER,
+                LITERAL,
+                SLASH,          //read a '/', waiting to see if it starts a comment
+                LINE_COMMENT,
+                BLOCK_COMMENT,
+            };
+            
+            struct frame {
+                char bracket;//'[' or '{'
+                size_t members;
+            };
+            
+            Handler &h;
+            ParseOptions options;
+            std::vector<frame> stack;//open containers
+            state_t state=VALUE;
+            scan_t mode=STRUCTURE;
+            
+            std::string token;//partial string body, number or literal
+            std::string scratch;//decoded strings
+            const char * literal=nullptr;//literal being matched
+            size_t token_start=0;//position of the first character of the token
+            bool is_key=false;
+            bool escaped=false;
+            bool plain=true;//string has no escapes or raw newlines
+            bool star=false;//last character in a block comment was '*'
+            
+            size_t consumed=0;
+            
+            void run(const char * data,size_t len,size_t at);
+            void structure(char c,size_t pos);
+            void open(char c,size_t pos);
+            void member(size_t pos);
+            void value_done();
+            void check_token(size_t pos);
+            void end_string(size_t pos);
+            void end_number(const char * next,size_t next_pos);
+            [[noreturn]] void unexpected(char c,size_t pos) const;
+            [[noreturn]] void unexpected_eof() const;
+    };
+    
+    //push parser that collects every completed top-level value as an Element
+    class ElementStream {
+        public:
+            explicit ElementStream(const ParseOptions &options=ParseOptions());
+            
+            inline void feed(const char * data,size_t len){ parser.feed(data,len); }
+            inline void feed(std::string_view data){ parser.feed(data); }
+            inline void finish(){ parser.finish(); }
+            
+            //true if there are completed values waiting to be taken
+            inline bool has_next() const { return !ready.empty(); }
+            
+            //takes the oldest completed value, throws std::out_of_range if there's none
+            Element next();
+        
+        private:
+            class Collector final : public Handler {
+                public:
+                    inline Collector(std::deque<Element> &out) : ready(out) {}
+                    
+                    void on_object_start() override;
+                    void on_key(std::string_view key) override;
+                    void on_object_end() override;
+                    
+                    void on_array_start() override;
+                    void on_array_end() override;
+                    
+                    void on_string(std::string_view s) override;
+                    void on_int(int64_t i) override;
+                    void on_double(double d) override;
+                    void on_literal(JSON_Literal l) override;
+                
+                private:
+                    ElementBuilder builder;
+                    std::deque<Element> &ready;
+                    
+                    void check();
+            };
+            
+            std::deque<Element> ready;
+            Collector collector;
+            StreamParser parser;
+    };
+
+}
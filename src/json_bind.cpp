@@ -0,0 +1,224 @@
+#include "json_bind.h"
+#include "json_parser.h"
+
+namespace JSON {
+    
+    using namespace internal;
+    
+    namespace {
+        
+        const char * type_name(std::string_view data,size_t i){
+            switch(data[i]){
+            case '{':
+                return "Object";
+            case '[':
+                return "Array";
+            case '"':
+                return "String";
+            case 't':
+            case 'f':
+                return "Boolean";
+            case 'n':
+                return "Null";
+            default:
+                return is_number_start(data,i)?"Number":nullptr;
+            }
+        }
+        
+    }
+    
+    namespace bind_detail {
+        
+        void write_string(std::string &out,std::string_view s){
+            append_quoted(out,s);
+        }
+        
+        void write_int(std::string &out,int64_t i){
+            append_int(out,i);
+        }
+        
+        void write_uint(std::string &out,uint64_t u){
+            char buf[24];
+            auto res=std::to_chars(buf,buf+sizeof(buf),u);
+            out.append(buf,res.ptr);
+        }
+        
+        void write_double(std::string &out,double d){
+            append_double(out,d);
+        }
+        
+    }
+    
+    Reader::Reader(std::string_view input,const ParseOptions &opts) : data(input), options(opts) {
+        if(data.size()>options.max_size) throw std::runtime_error("Document size "+std::to_string(data.size())+" exceeds the maximum of "+std::to_string(options.max_size));
+    }
+    
+    void Reader::type_error(const char * expected){
+        skip_whitespace(data,i);
+        if(i>=data.size()) throw std::runtime_error(std::string("Expected ")+expected+", got EOF");
+        const char * got=type_name(data,i);
+        if(got) throw std::runtime_error(std::string("Expected ")+expected+", got "+got+" at pos "+std::to_string(i));
+        throw std::runtime_error(std::string("Expected ")+expected+", got '"+data[i]+"' at pos "+std::to_string(i));
+    }
+    
+    Reader::type_t Reader::peek(){
+        skip_whitespace(data,i);
+        if(i>=data.size()) throw std::runtime_error("Expected JSON, got EOF");
+        switch(data[i]){
+        case '{':
+            return OBJECT;
+        case '[':
+            return ARRAY;
+        case '"':
+            return STRING;
+        case 't':
+        case 'f':
+            return BOOLEAN;
+        case 'n':
+            return NULL_LITERAL;
+        default:
+            if(is_number_start(data,i)) return NUMBER;
+            throw std::runtime_error(std::string("Expected JSON, got '")+data[i]+"' at pos "+std::to_string(i));
+        }
+    }
+    
+    //opens a container, with the same depth limit as Parser::open
+    void Reader::open(char c,const char * expected){
+        skip_whitespace(data,i);
+        if(i>=data.size()||data[i]!=c)type_error(expected);
+        if(members.size()>=options.max_depth) throw std::runtime_error("Maximum depth of "+std::to_string(options.max_depth)+" exceeded at pos "+std::to_string(i));
+        i++;
+        members.push_back(0);
+    }
+    
+    //moves to the next member or element of the innermost container, returns false (and closes it) at its end
+    bool Reader::next(char close){
+        skip_whitespace(data,i);
+        if(i<data.size()&&data[i]==close){
+            i++;
+            members.pop_back();
+            return false;
+        }
+        if(members.back()){
+            expect_char(data,i,',');
+            i++;
+            skip_whitespace(data,i);
+            if(i<data.size()&&data[i]==close){
+                i++;
+                members.pop_back();
+                return false;
+            }
+        }
+        if(i>=data.size()) throw std::runtime_error(std::string("Expected '")+close+"', got EOF");
+        if(++members.back()>options.max_members) throw std::runtime_error("Container has more than the maximum of "+std::to_string(options.max_members)+" members at pos "+std::to_string(i));
+        return true;
+    }
+    
+    std::string_view Reader::read_string(){
+        std::string_view s=internal::read_string(data,i,scratch,options.strict_strings);
+        if(s.size()>options.max_string_length) throw std::runtime_error("String length "+std::to_string(s.size())+" exceeds the maximum of "+std::to_string(options.max_string_length)+" at pos "+std::to_string(i));
+        return s;
+    }
+    
+    void Reader::begin_object(){
+        open('{',"Object");
+    }
+    
+    bool Reader::next_member(std::string_view &key){
+        if(!next('}'))return false;
+        key=read_string();
+        skip_whitespace(data,i);
+        expect_char(data,i,':');
+        i++;
+        return true;
+    }
+    
+    void Reader::begin_array(){
+        open('[',"Array");
+    }
+    
+    bool Reader::next_element(){
+        return next(']');
+    }
+    
+    std::string_view Reader::get_string(){
+        skip_whitespace(data,i);
+        if(i>=data.size()||data[i]!='"')type_error("String");
+        return read_string();
+    }
+    
+    int64_t Reader::get_int(){
+        skip_whitespace(data,i);
+        if(i>=data.size()||!is_number_start(data,i))type_error("Int");
+        size_t start=i;
+        Number n=get_number(data,i);
+        if(n.is_double) throw std::runtime_error("Expected Int, got Double at pos "+std::to_string(start));
+        return n.i;
+    }
+    
+    uint64_t Reader::get_uint(){
+        skip_whitespace(data,i);
+        if(i>=data.size()||!is_number_start(data,i))type_error("Int");
+        size_t start=i;
+        Number n=get_number(data,i);
+        if(!n.is_double){
+            if(n.i<0) throw std::runtime_error("Int "+std::to_string(n.i)+" out of range at pos "+std::to_string(i));
+            return static_cast<uint64_t>(n.i);
+        }
+        //integers above INT64_MAX are read as doubles, read them again as uint64_t
+        std::string_view text=data.substr(start,i-start);
+        std::string_view digits=text.substr(text[0]=='+'||text[0]=='-');
+        if(digits.find_first_not_of("0123456789")!=std::string_view::npos) throw std::runtime_error("Expected Int, got Double at pos "+std::to_string(start));
+        uint64_t u;
+        auto res=std::from_chars(digits.data(),digits.data()+digits.size(),u);
+        if(text[0]=='-'||res.ec!=std::errc()) throw std::runtime_error("Int "+std::string(text)+" out of range at pos "+std::to_string(i));
+        return u;
+    }
+    
+    double Reader::get_double(){
+        skip_whitespace(data,i);
+        if(i>=data.size()||!is_number_start(data,i))type_error("Number");
+        Number n=get_number(data,i);
+        return n.is_double?n.d:static_cast<double>(n.i);
+    }
+    
+    bool Reader::get_bool(){
+        skip_whitespace(data,i);
+        if(data.substr(i,4)=="true"){
+            i+=4;
+            return true;
+        }
+        if(data.substr(i,5)=="false"){
+            i+=5;
+            return false;
+        }
+        type_error("Boolean");
+    }
+    
+    bool Reader::get_null(){
+        skip_whitespace(data,i);
+        if(data.substr(i,4)=="null"){
+            i+=4;
+            return true;
+        }
+        return false;
+    }
+    
+    void Reader::skip(){
+        SkipHandler h;
+        Parser<SkipHandler> p(data,h,i,options);
+        p.outer_depth=members.size();
+        p.get_element();
+        i=p.i;
+    }
+    
+    Element Reader::get_element(){
+        ElementBuilder b;
+        Parser<ElementBuilder> p(data,b,i,options);
+        p.outer_depth=members.size();
+        p.get_element();
+        i=p.i;
+        return b.take();
+    }
+
+}
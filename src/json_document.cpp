@@ -0,0 +1,252 @@
+#include "json_document.h"
+#include "json_parser.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <new>
+
+namespace JSON {
+    
+    void * Arena::allocate(size_t size,size_t align){
+        size_t pad=(align-(reinterpret_cast<uintptr_t>(cur)&(align-1)))&(align-1);
+        if(size+pad>left){
+            size_t block=std::max(next_block,size+align);
+            blocks.emplace_back(new char[block]);
+            cur=blocks.back().get();
+            left=block;
+            reserved+=block;
+            next_block=std::min<size_t>(next_block*2,1024*1024);
+            pad=(align-(reinterpret_cast<uintptr_t>(cur)&(align-1)))&(align-1);
+        }
+        void * p=cur+pad;
+        cur+=pad+size;
+        left-=pad+size;
+        return p;
+    }
+    
+    const Value & ArrayView::at(size_t i) const {
+        if(i>=len) throw std::out_of_range("Array index "+std::to_string(i)+" out of range");
+        return ptr[i];
+    }
+    
+    const Member * ObjectView::find(std::string_view key) const {
+        #ifdef JSON_ORDERED_OBJECTS
+        const uint32_t * index=reinterpret_cast<const uint32_t*>(ptr+len);
+        const uint32_t * it=std::lower_bound(index,index+len,key,[this](uint32_t j,std::string_view k){
+            return ptr[j].first<k;
+        });
+        return (it!=index+len&&ptr[*it].first==key)?ptr+*it:end();
+        #else
+        const Member * it=std::lower_bound(begin(),end(),key,[](const Member &m,std::string_view k){
+            return m.first<k;
+        });
+        return (it!=end()&&it->first==key)?it:end();
+        #endif
+    }
+    
+    const Value & ObjectView::at(std::string_view key) const {
+        const Member * it=find(key);
+        if(it==end()) throw std::out_of_range("Key '"+std::string(key)+"' not found");
+        return it->second;
+    }
+    
+    Element Value::to_element() const {
+        switch(t){
+        case INT:
+            return Element(v.i);
+        case DOUBLE:
+            return Element(v.d);
+        case STRING:
+            return Element(std::string(v.str.ptr,v.str.len));
+        case LITERAL:
+            return Element(v.l);
+        case ARRAY:{
+                std::vector<Element> a;
+                a.reserve(v.arr.len);
+                for(const Value &e:get_arr()){
+                    a.emplace_back(e.to_element());
+                }
+                return JSON::Array(std::move(a));
+            }
+        case OBJECT:{
+                Element::object_t m;
+                for(const Member &e:get_obj()){
+                    m.try_emplace(m.end(),std::string(e.first),e.second.to_element());
+                }
+                return JSON::Object(std::move(m));
+            }
+        }
+        __builtin_unreachable();
+    }
+    
+    //builds Values directly into the document's arena, children are collected on a scratch stack and copied into a single arena block when their container closes
+    class DocumentBuilder {
+        public:
+            inline DocumentBuilder(Document &document,std::string_view borrow_from) : doc(document), source(borrow_from) {}
+            
+            void on_object_start(){
+                frames.push_back({values.size(),keys.size()});
+            }
+            
+            void on_key(std::string_view key){
+                keys.push_back(intern(key));
+            }
+            
+            void on_object_end(){
+                frame f=frames.back();
+                frames.pop_back();
+                size_t n=values.size()-f.values;
+                Member * members;
+                #ifdef JSON_ORDERED_OBJECTS
+                //document order, first one wins for duplicate keys, same as ObjectMap, plus the positions sorted by key
+                order.resize(n);
+                for(size_t j=0;j<n;j++)order[j]=j;
+                std::stable_sort(order.begin(),order.end(),[&](uint32_t a,uint32_t b){
+                    return keys[f.keys+a]<keys[f.keys+b];
+                });
+                kept.assign(n,1);
+                for(size_t j=1;j<n;j++){
+                    if(keys[f.keys+order[j]]==keys[f.keys+order[j-1]])kept[order[j]]=0;
+                }
+                position.resize(n);
+                size_t count=0;
+                for(size_t j=0;j<n;j++){
+                    position[j]=count;
+                    count+=kept[j];
+                }
+                members=static_cast<Member*>(doc.arena.allocate(count*(sizeof(Member)+sizeof(uint32_t)),alignof(Member)));
+                uint32_t * index=reinterpret_cast<uint32_t*>(members+count);
+                for(size_t j=0,k=0;j<n;j++){
+                    if(kept[j])new(members+position[j]) Member{keys[f.keys+j],values[f.values+j]};
+                    if(kept[order[j]])index[k++]=position[order[j]];
+                }
+                n=count;
+                #else
+                members=doc.arena.allocate_array<Member>(n);
+                for(size_t j=0;j<n;j++){
+                    new(members+j) Member{keys[f.keys+j],values[f.values+j]};
+                }
+                //keep the same order and duplicate key handling (first one wins) as the default std::map objects in Element
+                std::stable_sort(members,members+n,[](const Member &a,const Member &b){
+                    return a.first<b.first;
+                });
+                n=std::unique(members,members+n,[](const Member &a,const Member &b){
+                    return a.first==b.first;
+                })-members;
+                #endif
+                values.resize(f.values);
+                keys.resize(f.keys);
+                Value v;
+                v.t=Value::OBJECT;
+                v.v.obj.ptr=members;
+                v.v.obj.len=n;
+                add(v);
+            }
+            
+            void on_array_start(){
+                frames.push_back({values.size(),keys.size()});
+            }
+            
+            void on_array_end(){
+                frame f=frames.back();
+                frames.pop_back();
+                size_t n=values.size()-f.values;
+                Value * items=doc.arena.allocate_array<Value>(n);
+                std::uninitialized_copy(values.begin()+f.values,values.end(),items);
+                values.resize(f.values);
+                Value v;
+                v.t=Value::ARRAY;
+                v.v.arr.ptr=items;
+                v.v.arr.len=n;
+                add(v);
+            }
+            
+            void on_string(std::string_view s){
+                Value v;
+                v.t=Value::STRING;
+                v.v.str.ptr=copy(s);
+                v.v.str.len=s.size();
+                add(v);
+            }
+            
+            void on_int(int64_t i){
+                Value v;
+                v.t=Value::INT;
+                v.v.i=i;
+                add(v);
+            }
+            
+            void on_double(double d){
+                Value v;
+                v.t=Value::DOUBLE;
+                v.v.d=d;
+                add(v);
+            }
+            
+            void on_literal(JSON_Literal l){
+                Value v;
+                v.t=Value::LITERAL;
+                v.v.l=l;
+                add(v);
+            }
+        
+        private:
+            struct frame {
+                size_t values;
+                size_t keys;
+            };
+            
+            Document &doc;
+            std::string_view source;//strings that point into this are kept as-is instead of copied
+            std::vector<Value> values;
+            std::vector<std::string_view> keys;
+            std::vector<frame> frames;
+            #ifdef JSON_ORDERED_OBJECTS
+            std::vector<uint32_t> order,position;//scratch for sorting object members, reused
+            std::vector<uint8_t> kept;
+            #endif
+            
+            void add(const Value &v){
+                if(frames.empty()){
+                    doc.root_value=v;
+                }else{
+                    values.push_back(v);
+                }
+            }
+            
+            const char * copy(std::string_view s){
+                std::less<const char*> before;//unrelated pointers can't be compared with <
+                if(!before(s.data(),source.data())&&!before(source.data()+source.size(),s.data()+s.size())){
+                    return s.data();
+                }
+                char * p=static_cast<char*>(doc.arena.allocate(s.size(),1));
+                memcpy(p,s.data(),s.size());
+                return p;
+            }
+            
+            std::string_view intern(std::string_view key){
+                auto it=doc.keys.find(key);
+                if(it!=doc.keys.end())return *it;
+                std::string_view stored(copy(key),key.size());
+                doc.keys.insert(stored);
+                return stored;
+            }
+    };
+    
+    Document Document::parse(std::string_view data,const ParseOptions &options){
+        Document doc;
+        DocumentBuilder b(doc,std::string_view());
+        internal::Parser<DocumentBuilder> p(data,b,0,options);
+        p.get_element();
+        return doc;
+    }
+    
+    Document Document::parse_view(std::string_view data,const ParseOptions &options){
+        Document doc;
+        DocumentBuilder b(doc,data);
+        internal::Parser<DocumentBuilder> p(data,b,0,options);
+        p.get_element();
+        return doc;
+    }
+
+}
@@ -0,0 +1,185 @@
+#include "json_file.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__unix__)||defined(__APPLE__)
+#define JSON_HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <sstream>
+#endif
+
+namespace JSON {
+    
+    namespace {
+        
+        [[noreturn]] void fail(const std::string &path){
+            throw std::runtime_error(path+": "+strerror(errno));
+        }
+        
+        struct fault_counts {
+            size_t minor=0;
+            size_t major=0;
+        };
+        
+        //page faults so far, of the calling thread where that's available
+        fault_counts page_faults(){
+            fault_counts c;
+#ifdef JSON_HAVE_MMAP
+#ifdef RUSAGE_THREAD
+            int who=RUSAGE_THREAD;
+#else
+            int who=RUSAGE_SELF;
+#endif
+            struct rusage usage;
+            if(getrusage(who,&usage)==0){
+                c.minor=usage.ru_minflt;
+                c.major=usage.ru_majflt;
+            }
+#endif
+            return c;
+        }
+        
+    }
+
+#ifdef JSON_HAVE_MMAP
+    
+    MappedFile::MappedFile(const std::string &path){
+        int fd=open(path.c_str(),O_RDONLY);
+        if(fd<0)fail(path);
+        struct stat st;
+        if(fstat(fd,&st)<0){
+            int e=errno;
+            close(fd);
+            errno=e;
+            fail(path);
+        }
+        if(S_ISREG(st.st_mode)&&st.st_size>0){
+            void * p=mmap(nullptr,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+            if(p!=MAP_FAILED){
+                close(fd);
+                madvise(p,st.st_size,MADV_SEQUENTIAL);//the parser reads front to back, so the kernel can read ahead aggressively and drop pages behind
+                ptr=static_cast<const char*>(p);
+                len=st.st_size;
+                map_len=st.st_size;
+                return;
+            }
+            //mapping failed (some special filesystems don't support it), fall back to reading
+        }
+        //pipes, character devices and empty files can't (or needn't) be mapped
+        if(S_ISREG(st.st_mode))buffer.reserve(st.st_size);
+        char chunk[65536];
+        while(true){
+            ssize_t n=read(fd,chunk,sizeof(chunk));
+            if(n==0)break;
+            if(n<0){
+                if(errno==EINTR)continue;
+                int e=errno;
+                close(fd);
+                errno=e;
+                fail(path);
+            }
+            buffer.append(chunk,n);
+        }
+        close(fd);
+        ptr=buffer.data();
+        len=buffer.size();
+    }
+    
+    void MappedFile::release(){
+        if(map_len)munmap(const_cast<char*>(ptr),map_len);
+    }
+    
+    size_t MappedFile::resident_pages() const {
+        size_t page=page_size();
+        size_t pages=(len+page-1)/page;
+        if(!mapped())return pages;//a buffer that was just filled is fully resident
+#ifdef __APPLE__
+        std::vector<char> vec(pages);
+#else
+        std::vector<unsigned char> vec(pages);
+#endif
+        if(mincore(const_cast<char*>(ptr),len,vec.data())<0)return 0;
+        size_t n=0;
+        for(auto c:vec)n+=c&1;
+        return n;
+    }
+    
+    size_t MappedFile::page_size(){
+        return sysconf(_SC_PAGESIZE);
+    }
+
+#else
+    
+    MappedFile::MappedFile(const std::string &path){
+        std::ifstream f(path,std::ios::binary);
+        if(!f)fail(path);
+        std::ostringstream ss;
+        ss<<f.rdbuf();
+        buffer=std::move(ss).str();
+        ptr=buffer.data();
+        len=buffer.size();
+    }
+    
+    void MappedFile::release(){
+    }
+    
+    size_t MappedFile::resident_pages() const {
+        return (len+page_size()-1)/page_size();
+    }
+    
+    size_t MappedFile::page_size(){
+        return 4096;
+    }
+
+#endif
+    
+    MappedFile::~MappedFile(){
+        release();
+    }
+    
+    MappedFile::MappedFile(MappedFile &&other) noexcept : ptr(other.ptr), len(other.len), map_len(other.map_len), buffer(std::move(other.buffer)) {
+        if(!map_len)ptr=buffer.data();
+        other.ptr=nullptr;
+        other.len=0;
+        other.map_len=0;
+    }
+    
+    MappedFile& MappedFile::operator=(MappedFile &&other) noexcept {
+        if(this!=&other){
+            release();
+            ptr=other.ptr;
+            len=other.len;
+            map_len=other.map_len;
+            buffer=std::move(other.buffer);
+            if(!map_len)ptr=buffer.data();
+            other.ptr=nullptr;
+            other.len=0;
+            other.map_len=0;
+        }
+        return *this;
+    }
+    
+    Element parse_file(const std::string &path,FileStats * stats){
+        fault_counts before=page_faults();
+        MappedFile f(path);
+        Element e=parse(f.data());
+        if(stats){
+            fault_counts after=page_faults();
+            stats->file_size=f.size();
+            stats->bytes_read=f.bytes_read();
+            stats->pages_resident=f.resident_pages();
+            stats->minor_faults=after.minor-before.minor;
+            stats->major_faults=after.major-before.major;
+            stats->mapped=f.mapped();
+        }
+        return e;
+    }
+
+}
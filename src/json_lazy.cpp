@@ -0,0 +1,166 @@
+#include "json_lazy.h"
+#include "json_parser.h"
+
+namespace JSON {
+    
+    using namespace internal;
+    
+    //records the position of every value and key, and the end of every container's subtree, using the same grammar as the regular parser
+    class TapeBuilder {
+        public:
+            inline TapeBuilder(std::vector<LazyDocument::entry> &t) : tape(t) {}
+            
+            const size_t * start=nullptr;//the parser's start position
+            
+            inline void on_object_start(){ open(); }
+            inline void on_key(std::string_view){ leaf(); }
+            inline void on_object_end(){ close(); }
+            
+            inline void on_array_start(){ open(); }
+            inline void on_array_end(){ close(); }
+            
+            inline void on_string(std::string_view){ leaf(); }
+            inline void on_int(int64_t){ leaf(); }
+            inline void on_double(double){ leaf(); }
+            inline void on_literal(JSON_Literal){ leaf(); }
+        
+        private:
+            std::vector<LazyDocument::entry> &tape;
+            std::vector<size_t> stack;//open containers
+            
+            inline void open(){
+                stack.push_back(tape.size());
+                tape.push_back({*start,0});
+            }
+            
+            inline void leaf(){
+                tape.push_back({*start,tape.size()+1});
+            }
+            
+            inline void close(){
+                tape[stack.back()].next=tape.size();
+                stack.pop_back();
+            }
+    };
+    
+    LazyDocument::LazyDocument(std::string_view input,const ParseOptions &opts) : data(input), options(opts) {
+        TapeBuilder b(tape);
+        Parser<TapeBuilder> p(data,b,0,options);
+        b.start=&p.token_start;
+        p.get_element();
+    }
+    
+    bool LazyDocument::key_equals(size_t idx,std::string_view key) const {
+        std::string scratch;
+        size_t i=tape[idx].pos;
+        return read_string(data,i,scratch)==key;
+    }
+    
+    size_t LazyDocument::find(size_t idx,std::string_view key) const {
+        for(size_t j=idx+1;j<tape[idx].next;j=tape[j+1].next){
+            if(key_equals(j,key)) return j;
+        }
+        return LazyValue::npos;
+    }
+    
+    char LazyValue::first() const {
+        return doc->data[doc->tape[idx].pos];
+    }
+    
+    void LazyValue::require(char c) const {
+        if(first()!=c) throw std::bad_variant_access();
+    }
+    
+    bool LazyValue::is_num() const {
+        char c=first();
+        return is_number(c)||c=='-'||c=='+'||c=='.';
+    }
+    
+    bool LazyValue::is_str() const {
+        return first()=='"';
+    }
+    
+    bool LazyValue::is_arr() const {
+        return first()=='[';
+    }
+    
+    bool LazyValue::is_obj() const {
+        return first()=='{';
+    }
+    
+    bool LazyValue::is_lit() const {
+        char c=first();
+        return c=='n'||c=='t'||c=='f';
+    }
+    
+    bool LazyValue::contains(std::string_view key) const {
+        require('{');
+        return doc->find(idx,key)!=npos;
+    }
+    
+    LazyValue LazyValue::operator[](std::string_view key) const {
+        require('{');
+        size_t k=doc->find(idx,key);
+        if(k==npos) throw std::out_of_range("Key '"+std::string(key)+"' not found");
+        return LazyValue(doc,k+1,k);
+    }
+    
+    LazyValue LazyValue::operator[](size_t index) const {
+        require('[');
+        size_t end=doc->tape[idx].next;
+        size_t j=idx+1;
+        for(size_t n=0;n<index&&j<end;n++){
+            j=doc->tape[j].next;
+        }
+        if(j>=end) throw std::out_of_range("Array index "+std::to_string(index)+" out of range");
+        return LazyValue(doc,j);
+    }
+    
+    size_t LazyValue::size() const {
+        char c=first();
+        if(c!='['&&c!='{') throw std::bad_variant_access();
+        size_t n=0;
+        for(iterator it=begin(),e=end();it!=e;++it)n++;
+        return n;
+    }
+    
+    LazyValue::iterator LazyValue::begin() const {
+        char c=first();
+        if(c!='['&&c!='{') throw std::bad_variant_access();
+        return iterator(doc,idx+1,c=='{');
+    }
+    
+    LazyValue::iterator LazyValue::end() const {
+        char c=first();
+        if(c!='['&&c!='{') throw std::bad_variant_access();
+        return iterator(doc,doc->tape[idx].next,c=='{');
+    }
+    
+    std::string LazyValue::key() const {
+        if(key_idx==npos) throw std::logic_error("Value is not an object member");
+        std::string scratch;
+        size_t i=doc->tape[key_idx].pos;
+        return std::string(read_string(doc->data,i,scratch));
+    }
+    
+    size_t LazyValue::position() const {
+        return doc->tape[idx].pos;
+    }
+    
+    Element LazyValue::get() const {
+        ElementBuilder b;
+        Parser<ElementBuilder> p(doc->data,b,doc->tape[idx].pos,doc->options);
+        p.get_element();
+        return b.take();
+    }
+    
+    LazyValue LazyValue::iterator::operator*() const {
+        return object?LazyValue(doc,idx+1,idx):LazyValue(doc,idx);
+    }
+    
+    LazyValue::iterator& LazyValue::iterator::operator++(){
+        idx=doc->tape[object?idx+1:idx].next;
+        return *this;
+    }
+
+}
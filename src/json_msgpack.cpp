@@ -0,0 +1,396 @@
+#include "json_msgpack.h"
+#include "json_parser.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace JSON {
+    
+    namespace {
+        
+        template<typename T>
+        inline void append_be(std::string &out,T v){
+            char buf[sizeof(T)];
+            for(size_t j=0;j<sizeof(T);j++){
+                buf[j]=static_cast<char>(v>>(8*(sizeof(T)-1-j)));
+            }
+            out.append(buf,sizeof(T));
+        }
+        
+        //type byte followed by the smallest of a 16 or 32 bit length, or a fix type with the length in the low bits if it fits
+        //MessagePack has no wider lengths, larger strings and containers throw std::length_error instead of being written with a truncated length
+        inline void append_length(std::string &out,size_t n,uint8_t fix,size_t fix_max,uint8_t t8,uint8_t t16,uint8_t t32){
+            if(n>0xffffffff) throw std::length_error("Length "+std::to_string(n)+" exceeds the MessagePack maximum of 4294967295");
+            if(n<=fix_max){
+                out+=static_cast<char>(fix|n);
+            }else if(t8&&n<=0xff){
+                out+=static_cast<char>(t8);
+                out+=static_cast<char>(n);
+            }else if(n<=0xffff){
+                out+=static_cast<char>(t16);
+                append_be<uint16_t>(out,n);
+            }else{
+                out+=static_cast<char>(t32);
+                append_be<uint32_t>(out,n);
+            }
+        }
+        
+        inline void append_str(std::string &out,const std::string &s){
+            append_length(out,s.size(),0xa0,31,0xd9,0xda,0xdb);
+            out+=s;
+        }
+        
+        void append_int(std::string &out,int64_t i){
+            if(i>=0){
+                if(i<=0x7f){
+                    out+=static_cast<char>(i);//positive fixint
+                }else if(i<=0xff){
+                    out+='\xcc';
+                    out+=static_cast<char>(i);
+                }else if(i<=0xffff){
+                    out+='\xcd';
+                    append_be<uint16_t>(out,i);
+                }else if(i<=0xffffffff){
+                    out+='\xce';
+                    append_be<uint32_t>(out,i);
+                }else{
+                    out+='\xcf';
+                    append_be<uint64_t>(out,i);
+                }
+            }else{
+                if(i>=-32){
+                    out+=static_cast<char>(i);//negative fixint
+                }else if(i>=INT8_MIN){
+                    out+='\xd0';
+                    out+=static_cast<char>(i);
+                }else if(i>=INT16_MIN){
+                    out+='\xd1';
+                    append_be<uint16_t>(out,static_cast<uint16_t>(i));
+                }else if(i>=INT32_MIN){
+                    out+='\xd2';
+                    append_be<uint32_t>(out,static_cast<uint32_t>(i));
+                }else{
+                    out+='\xd3';
+                    append_be<uint64_t>(out,static_cast<uint64_t>(i));
+                }
+            }
+        }
+        
+        //iterative, open containers are kept on an explicit stack so nesting isn't limited by the call stack
+        void write_msgpack(const Element &root,std::string &out){
+            struct frame {
+                const Element * container;
+                size_t index;//next element, for arrays
+                Element::object_t::const_iterator it;//next member, for objects
+            };
+            std::vector<frame> stack;
+            const Element * e=&root;
+            while(e){
+                if(e->is_int()){
+                    append_int(out,e->get_int());
+                }else if(e->is_double()){
+                    uint64_t bits;
+                    double d=e->get_double();
+                    memcpy(&bits,&d,sizeof(bits));
+                    out+='\xcb';
+                    append_be<uint64_t>(out,bits);
+                }else if(e->is_str()){
+                    append_str(out,e->get_str());
+                }else if(e->is_arr()){
+                    append_length(out,e->get_arr().size(),0x90,15,0,0xdc,0xdd);
+                    stack.push_back({e,0,{}});
+                }else if(e->is_obj()){
+                    append_length(out,e->get_obj().size(),0x80,15,0,0xde,0xdf);
+                    stack.push_back({e,0,e->get_obj().begin()});
+                }else{
+                    JSON_Literal l=e->get_lit();
+                    out+=l==JSON_NULL?'\xc0':l==JSON_TRUE?'\xc3':'\xc2';
+                }
+                //next value to write, closing finished containers
+                e=nullptr;
+                while(!e&&!stack.empty()){
+                    frame &f=stack.back();
+                    if(f.container->is_arr()){
+                        if(f.index<f.container->get_arr().size()){
+                            e=&f.container->get_arr()[f.index++];
+                            break;
+                        }
+                    }else if(f.it!=f.container->get_obj().end()){
+                        append_str(out,f.it->first);
+                        e=&f.it->second;
+                        ++f.it;
+                        break;
+                    }
+                    stack.pop_back();
+                }
+            }
+        }
+        
+        //std::map can't reserve, ObjectMap can
+        template<typename T>
+        inline void reserve_members(std::map<std::string,T>&,size_t){
+        }
+        
+        template<typename T>
+        inline void reserve_members(ObjectMap<T> &m,size_t n){
+            m.reserve(n);
+        }
+        
+        //iterative like the text parser, with the same limits and error messages
+        class Decoder {
+            public:
+                inline Decoder(std::string_view input,const ParseOptions &opts) : data(input), i(0), options(opts) {}
+                
+                std::string_view data;
+                size_t i;
+                
+                Element get_element(){
+                    if(data.size()>options.max_size) throw std::runtime_error("Document size "+std::to_string(data.size())+" exceeds the maximum of "+std::to_string(options.max_size));
+                    std::vector<frame> stack;
+                    Element value;
+                    while(true){
+                        if(!stack.empty()&&stack.back().object)stack.back().key=get_key();
+                        if(!get_value(value,stack))continue;//opened a container that isn't empty
+                        //add the value to its container, closing every container that is then complete
+                        while(true){
+                            if(stack.empty())return value;
+                            frame &f=stack.back();
+                            if(f.object){
+                                f.container.get_obj().try_emplace(f.container.get_obj().end(),std::move(f.key),std::move(value));//encoded maps are usually already sorted, so the hint makes std::map inserts O(1), the first of a duplicate key wins
+                            }else{
+                                f.container.get_arr().push_back(std::move(value));
+                            }
+                            if(--f.left)break;
+                            value=std::move(f.container);
+                            stack.pop_back();
+                        }
+                    }
+                }
+            
+            private:
+                struct frame {
+                    Element container;
+                    size_t left;//values still to read
+                    bool object;
+                    std::string key;//key of the value being read, for objects
+                };
+                
+                ParseOptions options;
+                
+                static std::string hex(uint8_t t){
+                    const char * digits="0123456789abcdef";
+                    return std::string("0x")+digits[t>>4]+digits[t&0xf];
+                }
+                
+                inline void need(size_t n){
+                    if(data.size()-i<n) throw std::runtime_error("Expected MessagePack, got EOF");
+                }
+                
+                inline uint8_t byte(){
+                    need(1);
+                    return static_cast<uint8_t>(data[i++]);
+                }
+                
+                template<typename T>
+                inline T be(){
+                    need(sizeof(T));
+                    T v=0;
+                    for(size_t j=0;j<sizeof(T);j++){
+                        v=static_cast<T>((v<<8)|static_cast<uint8_t>(data[i+j]));
+                    }
+                    i+=sizeof(T);
+                    return v;
+                }
+                
+                //every value takes at least one byte, so a length can't be more than the bytes left, checked before reserving so bogus lengths can't allocate
+                inline size_t count(size_t n){
+                    need(std::min(n,data.size()-i+1));
+                    return n;
+                }
+                
+                //str (but not bin) is UTF-8 checked in strict mode, pos is where the value starts
+                std::string_view get_raw(size_t n,size_t pos,bool text){
+                    need(n);
+                    if(n>options.max_string_length) throw std::runtime_error("String length "+std::to_string(n)+" exceeds the maximum of "+std::to_string(options.max_string_length)+" at pos "+std::to_string(pos));
+                    std::string_view s=data.substr(i,n);
+                    if(text&&options.strict_strings){
+                        for(size_t j=0;j<n;){
+                            uint32_t cp;
+                            size_t len=internal::decode_utf8(s,j,cp);
+                            if(len==0) throw std::runtime_error("Invalid UTF-8 in string at pos "+std::to_string(i+j));
+                            j+=len;
+                        }
+                    }
+                    i+=n;
+                    return s;
+                }
+                
+                Element get_str(size_t n,size_t pos,bool text){
+                    return Element(std::string(get_raw(n,pos,text)));
+                }
+                
+                std::string get_key(){
+                    size_t pos=i;
+                    uint8_t t=byte();
+                    size_t len;
+                    if((t&0xe0)==0xa0){
+                        len=t&0x1f;
+                    }else if(t==0xd9||t==0xc4){
+                        len=be<uint8_t>();
+                    }else if(t==0xda||t==0xc5){
+                        len=be<uint16_t>();
+                    }else if(t==0xdb||t==0xc6){
+                        len=be<uint32_t>();
+                    }else{
+                        throw std::runtime_error("Expected MessagePack string key, got "+hex(t)+" at pos "+std::to_string(pos));
+                    }
+                    return std::string(get_raw(len,pos,t<0xc4||t>0xc6));
+                }
+                
+                //pushes a frame for containers that aren't empty, returns false then
+                bool open(Element &value,std::vector<frame> &stack,size_t n,bool object,size_t pos){
+                    if(stack.size()>=options.max_depth) throw std::runtime_error("Maximum depth of "+std::to_string(options.max_depth)+" exceeded at pos "+std::to_string(pos));
+                    if(n>options.max_members) throw std::runtime_error("Container has more than the maximum of "+std::to_string(options.max_members)+" members at pos "+std::to_string(pos));
+                    Element container;
+                    if(object){
+                        reserve_members(container.data.emplace<Element::object_t>(),count(n*2)/2);
+                    }else{
+                        container.data.emplace<std::vector<Element>>().reserve(count(n));
+                    }
+                    if(n==0){
+                        value=std::move(container);
+                        return true;
+                    }
+                    stack.push_back({std::move(container),n,object,std::string()});
+                    return false;
+                }
+                
+                //reads a scalar into value and returns true, or opens a container
+                bool get_value(Element &value,std::vector<frame> &stack){
+                    size_t pos=i;
+                    uint8_t t=byte();
+                    if(t<=0x7f){
+                        value=Element(static_cast<int64_t>(t));
+                        return true;
+                    }
+                    if(t>=0xe0){
+                        value=Element(static_cast<int64_t>(static_cast<int8_t>(t)));
+                        return true;
+                    }
+                    if((t&0xe0)==0xa0){
+                        value=get_str(t&0x1f,pos,true);
+                        return true;
+                    }
+                    if((t&0xf0)==0x90) return open(value,stack,t&0x0f,false,pos);
+                    if((t&0xf0)==0x80) return open(value,stack,t&0x0f,true,pos);
+                    switch(t){
+                    case 0xc0:
+                        value=Element(JSON_NULL);
+                        break;
+                    case 0xc2:
+                        value=Element(JSON_FALSE);
+                        break;
+                    case 0xc3:
+                        value=Element(JSON_TRUE);
+                        break;
+                    case 0xc4:
+                        value=get_str(be<uint8_t>(),pos,false);
+                        break;
+                    case 0xc5:
+                        value=get_str(be<uint16_t>(),pos,false);
+                        break;
+                    case 0xc6:
+                        value=get_str(be<uint32_t>(),pos,false);
+                        break;
+                    case 0xd9:
+                        value=get_str(be<uint8_t>(),pos,true);
+                        break;
+                    case 0xda:
+                        value=get_str(be<uint16_t>(),pos,true);
+                        break;
+                    case 0xdb:
+                        value=get_str(be<uint32_t>(),pos,true);
+                        break;
+                    case 0xca:{
+                        uint32_t bits=be<uint32_t>();
+                        float f;
+                        memcpy(&f,&bits,sizeof(f));
+                        value=Element(static_cast<double>(f));
+                        break;
+                    }
+                    case 0xcb:{
+                        uint64_t bits=be<uint64_t>();
+                        double d;
+                        memcpy(&d,&bits,sizeof(d));
+                        value=Element(d);
+                        break;
+                    }
+                    case 0xcc:
+                        value=Element(static_cast<int64_t>(be<uint8_t>()));
+                        break;
+                    case 0xcd:
+                        value=Element(static_cast<int64_t>(be<uint16_t>()));
+                        break;
+                    case 0xce:
+                        value=Element(static_cast<int64_t>(be<uint32_t>()));
+                        break;
+                    case 0xcf:{
+                        uint64_t u=be<uint64_t>();
+                        if(u>static_cast<uint64_t>(INT64_MAX)){
+                            value=Element(static_cast<double>(u));
+                        }else{
+                            value=Element(static_cast<int64_t>(u));
+                        }
+                        break;
+                    }
+                    case 0xd0:
+                        value=Element(static_cast<int64_t>(static_cast<int8_t>(be<uint8_t>())));
+                        break;
+                    case 0xd1:
+                        value=Element(static_cast<int64_t>(static_cast<int16_t>(be<uint16_t>())));
+                        break;
+                    case 0xd2:
+                        value=Element(static_cast<int64_t>(static_cast<int32_t>(be<uint32_t>())));
+                        break;
+                    case 0xd3:
+                        value=Element(static_cast<int64_t>(be<uint64_t>()));
+                        break;
+                    case 0xdc:
+                        return open(value,stack,be<uint16_t>(),false,pos);
+                    case 0xdd:
+                        return open(value,stack,be<uint32_t>(),false,pos);
+                    case 0xde:
+                        return open(value,stack,be<uint16_t>(),true,pos);
+                    case 0xdf:
+                        return open(value,stack,be<uint32_t>(),true,pos);
+                    default:
+                        throw std::runtime_error("Unsupported MessagePack type "+hex(t)+" at pos "+std::to_string(pos));
+                    }
+                    return true;
+                }
+        };
+        
+    }
+    
+    void to_msgpack(const Element &e,std::string &out){
+        write_msgpack(e,out);
+    }
+    
+    std::string to_msgpack(const Element &e){
+        std::string out;
+        write_msgpack(e,out);
+        return out;
+    }
+    
+    Element from_msgpack(std::string_view data){
+        return from_msgpack(data,ParseOptions());
+    }
+    
+    Element from_msgpack(std::string_view data,const ParseOptions &options){
+        Decoder d(data,options);
+        Element e=d.get_element();
+        if(d.i!=data.size()) throw std::runtime_error("Expected EOF, got MessagePack at pos "+std::to_string(d.i));
+        return e;
+    }
+
+}
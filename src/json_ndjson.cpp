@@ -0,0 +1,88 @@
+#include "json_ndjson.h"
+#include "json_parser.h"
+#include "json_threads.h"
+
+namespace JSON {
+    
+    using namespace internal;
+    
+    namespace {
+        
+        struct chunk {
+            size_t begin;
+            size_t end;//one past a newline, or the end of the data
+            size_t lines=0;//lines that start in the chunk
+            std::vector<Record> records;//line numbers relative to the chunk until they're fixed up
+        };
+        
+        //splits data into chunks of about chunk_size bytes that end at a newline
+        std::vector<chunk> split_chunks(std::string_view data,size_t chunk_size){
+            std::vector<chunk> chunks;
+            if(chunk_size==0)chunk_size=1;
+            size_t begin=0;
+            while(begin<data.size()){
+                size_t end=begin+chunk_size;
+                if(end>=data.size()){
+                    end=data.size();
+                }else{
+                    end=data.find('\n',end);
+                    end=end==std::string_view::npos?data.size():end+1;
+                }
+                chunks.push_back({begin,end});
+                begin=end;
+            }
+            return chunks;
+        }
+        
+        //each line is parsed as its own document, so error positions are relative to the line, same as calling parse on the line
+        void parse_chunk(std::string_view data,chunk &c,const ParseOptions &options){
+            for(size_t start=c.begin;start<c.end;c.lines++){
+                size_t nl=data.find('\n',start);
+                if(nl==std::string_view::npos||nl>=c.end)nl=c.end;
+                std::string_view text=data.substr(start,nl-start);
+                size_t i=0;
+                while(true){
+                    skip_whitespace(text,i);
+                    if(i>=text.size())break;
+                    Record r;
+                    r.line=c.lines;
+                    r.offset=start+i;
+                    try{
+                        ElementBuilder b;
+                        Parser<ElementBuilder> p(text,b,i,options);
+                        p.get_element();
+                        r.value=b.take();
+                        i=p.i;
+                    }catch(std::exception &e){
+                        r.error=e.what();
+                        i=text.size();//can't resynchronize inside a line, skip the rest of it
+                    }
+                    c.records.push_back(std::move(r));
+                }
+                start=nl+1;
+            }
+        }
+        
+    }
+    
+    std::vector<Record> parse_lines(std::string_view data,const BatchOptions &options){
+        std::vector<chunk> chunks=split_chunks(data,options.chunk_size);
+        spawn_for(chunks.size(),options.threads,[&](size_t n){
+            parse_chunk(data,chunks[n],options.parse_options);
+        });
+        size_t total=0;
+        for(const chunk &c:chunks)total+=c.records.size();
+        std::vector<Record> records;
+        records.reserve(total);
+        size_t line=1;
+        for(chunk &c:chunks){
+            for(Record &r:c.records){
+                r.line+=line;
+                records.push_back(std::move(r));
+            }
+            line+=c.lines;
+        }
+        return records;
+    }
+
+}
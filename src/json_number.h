@@ -0,0 +1,140 @@
+#pragma once
+
+//internal number engine: exact decimal to binary conversion on input, shortest round-trip formatting on output
+
+#include "json_scan.h"
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace JSON {
+    
+    namespace internal {
+        
+        struct Number {
+            bool is_double;
+            union {
+                int64_t i;
+                double d;
+            };
+        };
+        
+        //whether a decimal number that std::from_chars reported as out of range overflows, underflows read as 0
+        inline bool out_of_range_overflows(std::string_view digits,std::string_view exponent){
+            int64_t magnitude=0;//position of the first significant digit relative to the decimal point
+            size_t dot=digits.find('.');
+            size_t int_len=dot==std::string_view::npos?digits.size():dot;
+            size_t first=digits.find_first_not_of("0.");
+            if(first==std::string_view::npos) return false;
+            magnitude=first<int_len?int_len-first:-static_cast<int64_t>(first-int_len);
+            int64_t exp=0;
+            bool exp_negative=!exponent.empty()&&exponent[0]=='-';
+            for(char c:exponent){
+                if(c>='0'&&c<='9'&&exp<100000)(exp*=10)+=c-'0';
+            }
+            magnitude+=exp_negative?-exp:exp;
+            return magnitude>0;
+        }
+        
+        //handles integers, decimals and scientific notation
+        //integers that don't fit in an int64_t are read as doubles, doubles are correctly rounded
+        //numbers too large for a double throw std::range_error, since infinity can't be written back as JSON
+        inline Number get_number(std::string_view data, size_t &i){
+            if(i>=data.size()) throw std::runtime_error("Expected Number, got EOF");
+            size_t begin=i;
+            bool is_negative=data[i]=='-';
+            if(data[i]=='-'||data[i]=='+')i++;
+            
+            size_t start=i;
+            i=skip_digits(data,i);
+            bool valid=i>start;
+            bool is_double=false;
+            size_t exp_start=0;
+            
+            if(i<data.size()&&data[i]=='.'){
+                is_double=true;
+                size_t frac=++i;
+                i=skip_digits(data,i);
+                valid=valid||i>frac;
+            }
+            if(valid&&i<data.size()&&(data[i]=='e'||data[i]=='E')){
+                is_double=true;
+                exp_start=++i;
+                if(i<data.size()&&(data[i]=='+'||data[i]=='-'))i++;
+                size_t digits=i;
+                i=skip_digits(data,i);
+                valid=i>digits;
+            }
+            
+            if(!valid){
+                if(i>=data.size()){
+                    throw std::runtime_error("Expected Number, got EOF");
+                }else{
+                    throw std::runtime_error(std::string("Expected Number, got '")+data[i]+"' at pos "+std::to_string(i));
+                }
+            }
+            
+            Number n;
+            if(!is_double){
+                //fast path, up to 18 digits can't overflow
+                uint64_t v=0;
+                size_t len=i-start;
+                const char * p=data.data()+start;
+                if(len<=18){
+                    for(size_t j=0;j<len;j++)(v*=10)+=p[j]-'0';
+                    n.is_double=false;
+                    n.i=is_negative?-static_cast<int64_t>(v):static_cast<int64_t>(v);
+                    return n;
+                }
+                uint64_t limit=is_negative?uint64_t(1)<<63:(uint64_t(1)<<63)-1;
+                bool overflow=false;
+                for(size_t j=0;j<len&&!overflow;j++){
+                    overflow=__builtin_mul_overflow(v,10,&v)||__builtin_add_overflow(v,static_cast<uint64_t>(p[j]-'0'),&v);
+                }
+                if(!overflow&&v<=limit){
+                    n.is_double=false;
+                    n.i=is_negative?static_cast<int64_t>(0-v):static_cast<int64_t>(v);
+                    return n;
+                }
+                //too large for int64_t, promote to double
+            }
+            
+            double d=0;
+            auto res=std::from_chars(data.data()+start,data.data()+i,d);
+            if(res.ec==std::errc::result_out_of_range){
+                std::string_view digits=data.substr(start,(exp_start?exp_start-1:i)-start);
+                std::string_view exponent=exp_start?data.substr(exp_start,i-exp_start):std::string_view();
+                if(out_of_range_overflows(digits,exponent)) throw std::range_error("Number out of range at pos "+std::to_string(begin));
+                d=0.0;
+            }
+            n.is_double=true;
+            n.d=is_negative?-d:d;
+            return n;
+        }
+        
+        inline void append_int(std::string &out,int64_t i){
+            char buf[24];
+            auto res=std::to_chars(buf,buf+sizeof(buf),i);
+            out.append(buf,res.ptr);
+        }
+        
+        //shortest representation that reads back as the same double, always written so that it's read back as a double and not an integer
+        //infinity and NaN have no JSON representation and are written as null
+        inline void append_double(std::string &out,double d){
+            if(!std::isfinite(d)){
+                out+="null";
+                return;
+            }
+            char buf[32];
+            auto res=std::to_chars(buf,buf+sizeof(buf),d);
+            out.append(buf,res.ptr);
+            if(std::char_traits<char>::find(buf,res.ptr-buf,'.')==nullptr&&std::char_traits<char>::find(buf,res.ptr-buf,'e')==nullptr){
+                out+=".0";
+            }
+        }
+        
+    }
+
+}
@@ -0,0 +1,241 @@
+#include "json_parallel.h"
+#include "json_parser.h"
+#include "json_threads.h"
+#include <cstring>
+
+namespace JSON {
+    
+    using namespace internal;
+    
+    namespace {
+        
+        constexpr size_t sample_count=16;//children looked at when estimating a large container
+        constexpr size_t exact_children=64;//containers with more children than this are split evenly by count instead of by each child's estimate
+        constexpr size_t max_plan_depth=64;//nesting below which subtrees are never split or looked into, so neither pass recurses unbounded
+        
+        //a piece of the output, either fixed text (brackets, separators, indentation and keys) or a run of children of one container that a thread writes
+        struct segment {
+            std::string text;//the fixed text, or the run's output once it's written
+            const Element * container=nullptr;//null for fixed text
+            size_t first=0;//index of the first child in the run
+            size_t count=0;
+            Element::object_t::const_iterator it;//first member of the run for objects
+            size_t depth=0;//depth of the container
+        };
+        
+        class Planner {
+            public:
+                inline Planner(bool p,bool t,bool a,size_t c) : pretty(p), trailing_quote(t), ascii_only(a), chunk_size(c) {}
+                
+                std::vector<segment> segments;
+                
+                //rough size of e's output, containers with many children are extrapolated from a sample
+                size_t estimate(const Element &e,size_t depth,size_t level=0) const {
+                    if(e.is_int())return 8;
+                    if(e.is_double())return 16;
+                    if(e.is_str())return e.get_str().size()+2;
+                    if(e.is_lit())return 5;
+                    if(level>=max_plan_depth)return 16;
+                    size_t overhead=pretty?(depth+1)*4+2:1;//indent and separator per child
+                    size_t total=0;
+                    size_t sampled=0;
+                    size_t n;
+                    if(e.is_arr()){
+                        const std::vector<Element> &arr=e.get_arr();
+                        n=arr.size();
+                        size_t step=n>sample_count?n/sample_count:1;
+                        for(size_t j=0;j<n&&sampled<sample_count;j+=step,sampled++){
+                            total+=estimate(arr[j],depth+1,level+1)+overhead;
+                        }
+                    }else{
+                        const Element::object_t &obj=e.get_obj();
+                        n=obj.size();
+                        for(auto c=obj.begin();c!=obj.end()&&sampled<sample_count;++c,sampled++){
+                            total+=estimate(c->second,depth+1,level+1)+overhead+c->first.size()+(pretty?5:3);
+                        }
+                    }
+                    if(sampled<n)total=total/sampled*n;
+                    return total+(pretty?depth*4+4:2);
+                }
+                
+                //adds the segments for a whole value that's at least chunk_size
+                void plan(const Element &e,size_t depth,size_t level){
+                    if(level>=max_plan_depth||!(e.is_arr()||e.is_obj())||(e.is_arr()?e.get_arr().empty():e.get_obj().empty())){
+                        add_whole(e,depth);
+                        return;
+                    }
+                    bool arr=e.is_arr();
+                    text(arr?'[':'{');
+                    if(pretty)text('\n');
+                    size_t n=arr?e.get_arr().size():e.get_obj().size();
+                    if(n>exact_children){
+                        //too many children to look at one by one, assume they're about the same size
+                        size_t per_run=std::max<size_t>(1,n*chunk_size/std::max<size_t>(1,estimate(e,depth,level)));
+                        auto it=arr?Element::object_t::const_iterator():e.get_obj().begin();
+                        for(size_t j=0;j<n;j+=per_run){
+                            size_t count=std::min(per_run,n-j);
+                            add_run(e,depth,j,count,it);
+                            if(!arr)it=std::next(it,count);
+                        }
+                    }else{
+                        //big children are split up further, runs of small ones in between are written as one segment
+                        size_t run_first=0;
+                        size_t run_size=0;
+                        auto run_it=arr?Element::object_t::const_iterator():e.get_obj().begin();
+                        auto it=run_it;
+                        for(size_t j=0;j<n;j++){
+                            const Element &c=arr?e.get_arr()[j]:it->second;
+                            size_t size=estimate(c,depth+1,level+1);
+                            if(size>=chunk_size&&(c.is_arr()||c.is_obj())){
+                                if(j>run_first)add_run(e,depth,run_first,j-run_first,run_it);
+                                if(j)text(pretty?",\n":",");
+                                if(pretty)text(std::string((depth+1)*4,' '));
+                                if(!arr){
+                                    append_quoted(last_text(),it->first,ascii_only);
+                                    text(pretty?" : ":":");
+                                }
+                                plan(c,depth+1,level+1);
+                                run_first=j+1;
+                                run_size=0;
+                                if(!arr)run_it=std::next(it);
+                            }else{
+                                run_size+=size;
+                                if(run_size>=chunk_size){
+                                    add_run(e,depth,run_first,j+1-run_first,run_it);
+                                    run_first=j+1;
+                                    run_size=0;
+                                    if(!arr)run_it=std::next(it);
+                                }
+                            }
+                            if(!arr)++it;
+                        }
+                        if(n>run_first)add_run(e,depth,run_first,n-run_first,run_it);
+                    }
+                    if(pretty){
+                        text(trailing_quote?",\n":"\n");
+                        text(std::string(depth*4,' '));
+                    }
+                    text(arr?']':'}');
+                }
+            
+            private:
+                bool pretty;
+                bool trailing_quote;
+                bool ascii_only;
+                size_t chunk_size;
+                
+                //consecutive fixed text goes in the same segment
+                std::string& last_text(){
+                    if(segments.empty()||segments.back().container)segments.emplace_back();
+                    return segments.back().text;
+                }
+                
+                inline void text(std::string_view s){
+                    last_text()+=s;
+                }
+                
+                inline void text(char c){
+                    last_text()+=c;
+                }
+                
+                //a value written whole by one thread, as a run of one child of a dummy container
+                void add_whole(const Element &e,size_t depth){
+                    segment s;
+                    s.container=&e;
+                    s.count=SIZE_MAX;
+                    s.depth=depth;
+                    segments.push_back(std::move(s));
+                }
+                
+                void add_run(const Element &container,size_t depth,size_t first,size_t count,Element::object_t::const_iterator it){
+                    segment s;
+                    s.container=&container;
+                    s.first=first;
+                    s.count=count;
+                    s.it=it;
+                    s.depth=depth;
+                    segments.push_back(std::move(s));
+                }
+        };
+        
+        inline void write_value(const Element &e,std::string &out,bool pretty,bool trailing_quote,bool ascii_only,size_t depth){
+            if(pretty){
+                e.to_json(out,trailing_quote,depth,ascii_only);
+            }else{
+                e.to_json_min(out,ascii_only);
+            }
+        }
+        
+        //writes a run of children the same way the sequential writer does, including the separator before it unless it's the first child
+        void write_segment(segment &s,bool pretty,bool trailing_quote,bool ascii_only){
+            std::string &out=s.text;
+            if(s.count==SIZE_MAX){
+                write_value(*s.container,out,pretty,trailing_quote,ascii_only,s.depth);
+                return;
+            }
+            bool arr=s.container->is_arr();
+            auto it=s.it;
+            for(size_t j=s.first;j<s.first+s.count;j++){
+                if(j)out+=pretty?",\n":",";
+                if(pretty)out.append((s.depth+1)*4,' ');
+                if(arr){
+                    write_value(s.container->get_arr()[j],out,pretty,trailing_quote,ascii_only,s.depth+1);
+                }else{
+                    append_quoted(out,it->first,ascii_only);
+                    out+=pretty?" : ":":";
+                    write_value(it->second,out,pretty,trailing_quote,ascii_only,s.depth+1);
+                    ++it;
+                }
+            }
+        }
+        
+        void write_parallel(const Element &e,std::string &out,bool pretty,bool trailing_quote,size_t depth,const SerializeOptions &options){
+            size_t chunk_size=std::max<size_t>(1,options.chunk_size);
+            Planner p(pretty,trailing_quote,options.ascii_only,chunk_size);
+            size_t threads=options.threads?options.threads:default_threads();
+            if(threads<=1||p.estimate(e,depth)<chunk_size*2){
+                write_value(e,out,pretty,trailing_quote,options.ascii_only,depth);
+                return;
+            }
+            p.plan(e,depth,0);
+            std::vector<segment> &segments=p.segments;
+            spawn_for(segments.size(),threads,[&](size_t j){
+                if(segments[j].container)write_segment(segments[j],pretty,trailing_quote,options.ascii_only);
+            });
+            //join the pieces, the copies are split between threads too since the output can be gigabytes
+            std::vector<size_t> offsets(segments.size());
+            size_t size=out.size();
+            for(size_t j=0;j<segments.size();j++){
+                offsets[j]=size;
+                size+=segments[j].text.size();
+            }
+            out.resize(size);
+            spawn_for(segments.size(),threads,[&](size_t j){
+                memcpy(&out[offsets[j]],segments[j].text.data(),segments[j].text.size());
+                std::string().swap(segments[j].text);
+            });
+        }
+        
+    }
+    
+    std::string to_json_parallel(const Element &e,bool trailing_quote,size_t depth,const SerializeOptions &options){
+        std::string out;
+        write_parallel(e,out,true,trailing_quote,depth,options);
+        return out;
+    }
+    
+    void to_json_parallel(const Element &e,std::string &out,bool trailing_quote,size_t depth,const SerializeOptions &options){
+        write_parallel(e,out,true,trailing_quote,depth,options);
+    }
+    
+    std::string to_json_min_parallel(const Element &e,const SerializeOptions &options){
+        std::string out;
+        write_parallel(e,out,false,false,0,options);
+        return out;
+    }
+    
+    void to_json_min_parallel(const Element &e,std::string &out,const SerializeOptions &options){
+        write_parallel(e,out,false,false,0,options);
+    }
+
+}
@@ -0,0 +1,457 @@
+#include "json_parallel.h"
+#include "json_parser.h"
+#include "json_threads.h"
+#include <cstring>
+#include <iterator>
+
+namespace JSON {
+    
+    using namespace internal;
+    
+    namespace {
+        
+        constexpr size_t npos=std::string_view::npos;
+        constexpr size_t max_descend=64;//levels of nesting looked into for the container that holds most of the document
+        
+        //where a byte is relative to strings and comments, carried from the end of one chunk into the next
+        enum lex_state : uint8_t {
+            LEX_NORMAL,
+            LEX_SLASH,//after a '/' outside strings, which starts a comment if a '/' or '*' follows
+            LEX_LINE_COMMENT,
+            LEX_BLOCK_COMMENT,
+            LEX_BLOCK_STAR,//after a '*' in a block comment
+            LEX_STRING,
+            LEX_ESCAPE,//after a '\\' in a string
+            LEX_STATES,
+        };
+        
+        struct chunk {
+            size_t begin;
+            size_t end;
+            //for every state the chunk could start in: the state at its end, the change in nesting depth and the lowest depth reached, relative to the start
+            lex_state exit[LEX_STATES];
+            int64_t delta[LEX_STATES];
+            int64_t low[LEX_STATES];
+            //actual state and depth at begin, known once the chunks before it are
+            lex_state entry=LEX_NORMAL;
+            int64_t depth=0;
+        };
+        
+        //a container whose members are parsed on several threads
+        struct target {
+            size_t open;//positions of its brackets
+            size_t close;
+            size_t depth;//nesting depth of its members
+            bool object;
+        };
+        
+        //members between two of the separators picked by the scan, parsed by one thread
+        struct run {
+            size_t begin;
+            size_t end;
+            std::vector<std::string> keys;
+            std::vector<Element> values;
+            bool trailing_comma=false;
+        };
+        
+        //walks [i,end) starting in state s, keeping depth and its lowest value up to date
+        //stop(pos,c,depth) is called for brackets, after depth changes, and with Commas for commas, outside strings and comments
+        //if it returns true the walk stops with i on that character, the state at i is returned
+        template<bool Commas,typename F>
+        lex_state lex(std::string_view data,size_t &i,size_t end,lex_state s,int64_t &depth,int64_t &low,F &&stop){
+            std::string_view v=data.substr(0,end);
+            while(i<end){
+                switch(s){
+                case LEX_NORMAL:{
+                    if constexpr(Commas){
+                        i=find_separator(v,i);
+                    }else{
+                        i=find_structural(v,i);
+                    }
+                    if(i>=end)break;
+                    char c=v[i];
+                    if(c=='"'){
+                        s=LEX_STRING;
+                    }else if(c=='/'){
+                        s=LEX_SLASH;
+                    }else{
+                        if(c=='['||c=='{'){
+                            depth++;
+                        }else if(c==']'||c=='}'){
+                            depth--;
+                            low=std::min(low,depth);
+                        }
+                        if(stop(i,c,depth))return s;
+                    }
+                    i++;
+                    break;
+                }
+                case LEX_SLASH:
+                    if(v[i]=='/'){
+                        s=LEX_LINE_COMMENT;
+                        i++;
+                    }else if(v[i]=='*'){
+                        s=LEX_BLOCK_COMMENT;
+                        i++;
+                    }else{
+                        s=LEX_NORMAL;
+                    }
+                    break;
+                case LEX_LINE_COMMENT:{
+                    const char *p=static_cast<const char*>(memchr(v.data()+i,'\n',end-i));
+                    if(!p){
+                        i=end;
+                    }else{
+                        i=p-v.data()+1;
+                        s=LEX_NORMAL;
+                    }
+                    break;
+                }
+                case LEX_BLOCK_COMMENT:{
+                    const char *p=static_cast<const char*>(memchr(v.data()+i,'*',end-i));
+                    if(!p){
+                        i=end;
+                    }else{
+                        i=p-v.data()+1;
+                        s=LEX_BLOCK_STAR;
+                    }
+                    break;
+                }
+                case LEX_BLOCK_STAR:
+                    if(v[i]=='/'){
+                        s=LEX_NORMAL;
+                        i++;
+                    }else if(v[i]=='*'){
+                        i++;
+                    }else{
+                        s=LEX_BLOCK_COMMENT;
+                    }
+                    break;
+                case LEX_STRING:
+                    i=find_string_special(v,i);
+                    if(i>=end)break;
+                    if(v[i]=='"'){
+                        s=LEX_NORMAL;
+                    }else if(v[i]=='\\'){
+                        s=LEX_ESCAPE;
+                    }
+                    i++;//a raw newline stays in the string
+                    break;
+                case LEX_ESCAPE:
+                    s=LEX_STRING;
+                    i++;
+                    break;
+                default:
+                    i=end;
+                    break;
+                }
+            }
+            return s;
+        }
+        
+        inline bool never(size_t,char,int64_t){
+            return false;
+        }
+        
+        class ParallelParser {
+            public:
+                inline ParallelParser(std::string_view d,const ParseOptions &o,size_t t,size_t c) : data(d), options(o), threads(t), chunk_size(c) {}
+                
+                //returns false if anything doesn't add up, the caller then parses the document sequentially, which also reports the error if there is one
+                bool parse(Element &result){
+                    size_t root=0;
+                    skip_whitespace(data,root);
+                    if(root>=data.size()||(data[root]!='['&&data[root]!='{')||options.max_depth==0)return false;
+                    scan_chunks();
+                    target t{root,find_close(root,1),1,data[root]=='{'};
+                    if(t.close==npos)return false;
+                    size_t root_close=t.close;
+                    
+                    //split the container unless one of its members holds nearly all of it, then that member is split instead
+                    std::vector<size_t> separators;
+                    for(size_t level=0;;level++){
+                        separators=find_separators(t);
+                        size_t begin=0,end=0,prev=t.open;
+                        for(size_t j=0;j<=separators.size();j++){
+                            size_t next=j<separators.size()?separators[j]:t.close;
+                            if(next-prev>end-begin){
+                                begin=prev+1;
+                                end=next;
+                            }
+                            prev=next;
+                        }
+                        target child;
+                        if(level>=max_descend||end-begin<(t.close-t.open)/10*9||t.depth>=options.max_depth||!find_dominant(t,begin,end,child))break;
+                        t=child;
+                    }
+                    if(data[t.close]!=(t.object?'}':']'))return false;
+                    
+                    std::vector<run> runs(separators.size()+1);
+                    for(size_t j=0;j<runs.size();j++){
+                        runs[j].begin=(j?separators[j-1]:t.open)+1;
+                        runs[j].end=j<separators.size()?separators[j]:t.close;
+                    }
+                    ParseOptions inner=options;
+                    inner.max_depth-=t.depth;
+                    spawn_for(runs.size(),threads,[&](size_t j){
+                        parse_run(t,runs[j],inner);
+                    });
+                    Element container;
+                    if(!assemble(t,runs,container))return false;
+                    if(t.open==root){
+                        result=std::move(container);
+                        return true;
+                    }
+                    
+                    //what's around the split container is small, it's parsed sequentially with a placeholder string in the container's place
+                    std::string marker="json-parse-parallel-placeholder-"+std::to_string(t.open);
+                    std::string outside;
+                    outside.reserve(t.open+marker.size()+2+root_close-t.close);
+                    outside.append(data.substr(0,t.open));
+                    outside+='"';
+                    outside+=marker;
+                    outside+='"';
+                    outside.append(data.substr(t.close+1,root_close-t.close));
+                    result=JSON::parse(outside,options);
+                    Element *slot=find_placeholder(result,marker);
+                    if(!slot)return false;
+                    *slot=std::move(container);
+                    return true;
+                }
+            
+            private:
+                std::string_view data;
+                ParseOptions options;
+                size_t threads;
+                size_t chunk_size;
+                std::vector<chunk> chunks;
+                
+                inline size_t chunk_of(size_t pos) const {
+                    return std::min(pos/chunk_size,chunks.size()-1);
+                }
+                
+                //first pass, the state at the start of a chunk depends on the chunks before it, so each one is walked from every state it could start in
+                //states that only differ in how the first byte is read share the walk of the state they fall back to
+                void scan_chunks(){
+                    chunks.resize((data.size()+chunk_size-1)/chunk_size);
+                    spawn_for(chunks.size(),threads,[&](size_t k){
+                        chunk &c=chunks[k];
+                        c.begin=k*chunk_size;
+                        c.end=std::min(c.begin+chunk_size,data.size());
+                        auto walk=[&](lex_state s){
+                            size_t i=c.begin;
+                            int64_t depth=0,low=0;
+                            c.exit[s]=lex<false>(data,i,c.end,s,depth,low,never);
+                            c.delta[s]=depth;
+                            c.low[s]=low;
+                        };
+                        auto same=[&](lex_state s,lex_state as){
+                            c.exit[s]=c.exit[as];
+                            c.delta[s]=c.delta[as];
+                            c.low[s]=c.low[as];
+                        };
+                        walk(LEX_NORMAL);
+                        if(k==0)return;
+                        walk(LEX_STRING);
+                        walk(LEX_LINE_COMMENT);
+                        walk(LEX_BLOCK_COMMENT);
+                        char first=data[c.begin];
+                        if(first=='"'||first=='\\'){
+                            walk(LEX_ESCAPE);
+                        }else{
+                            same(LEX_ESCAPE,LEX_STRING);
+                        }
+                        if(first=='/'||first=='*'){
+                            walk(LEX_SLASH);
+                            walk(LEX_BLOCK_STAR);
+                        }else{
+                            same(LEX_SLASH,LEX_NORMAL);
+                            same(LEX_BLOCK_STAR,LEX_BLOCK_COMMENT);
+                        }
+                    });
+                    for(size_t k=1;k<chunks.size();k++){
+                        const chunk &prev=chunks[k-1];
+                        chunks[k].entry=prev.exit[prev.entry];
+                        chunks[k].depth=prev.depth+prev.delta[prev.entry];
+                    }
+                }
+                
+                //position of the bracket closing the one at open, whose members are at depth inside, or npos
+                //chunks that never get back to that depth are skipped without being read
+                size_t find_close(size_t open,int64_t inside) const {
+                    auto closes=[inside](size_t,char c,int64_t depth){
+                        return (c==']'||c=='}')&&depth<inside;
+                    };
+                    size_t k=chunk_of(open);
+                    size_t i=open+1;
+                    int64_t depth=inside,low=inside;
+                    lex<false>(data,i,chunks[k].end,LEX_NORMAL,depth,low,closes);
+                    if(i<chunks[k].end)return i;
+                    for(k++;k<chunks.size();k++){
+                        const chunk &c=chunks[k];
+                        if(c.depth+c.low[c.entry]>=inside)continue;
+                        i=c.begin;
+                        depth=low=c.depth;
+                        lex<false>(data,i,c.end,c.entry,depth,low,closes);
+                        return i<c.end?i:npos;
+                    }
+                    return npos;
+                }
+                
+                //second pass, the first comma between t's members in each chunk it covers
+                std::vector<size_t> find_separators(const target &t){
+                    size_t first=chunk_of(t.open);
+                    std::vector<size_t> found(chunk_of(t.close)-first+1,npos);
+                    spawn_for(found.size(),threads,[&](size_t j){
+                        const chunk &c=chunks[first+j];
+                        size_t i=j?c.begin:t.open+1;
+                        lex_state s=j?c.entry:LEX_NORMAL;
+                        int64_t depth=j?c.depth:static_cast<int64_t>(t.depth);
+                        int64_t low=depth;
+                        size_t end=std::min(c.end,t.close);
+                        lex<true>(data,i,end,s,depth,low,[&](size_t,char ch,int64_t d){
+                            return ch==','&&d==static_cast<int64_t>(t.depth);
+                        });
+                        if(i<end)found[j]=i;
+                    });
+                    found.erase(std::remove(found.begin(),found.end(),npos),found.end());
+                    return found;
+                }
+                
+                //reads the members of t in [begin,end) until one that's a container covering nearly all of t, without building anything
+                bool find_dominant(const target &t,size_t begin,size_t end,target &child) const {
+                    std::string_view v=data.substr(0,end);
+                    std::string scratch;
+                    SkipHandler h;
+                    Parser<SkipHandler> p(v,h,0,options);
+                    size_t i=begin;
+                    while(true){
+                        skip_whitespace(v,i);
+                        if(i>=end)return false;
+                        if(t.object){
+                            read_string(v,i,scratch,options.strict_strings);
+                            skip_whitespace(v,i);
+                            expect_char(v,i,':');
+                            i++;
+                            skip_whitespace(v,i);
+                            if(i>=end)return false;
+                        }
+                        if(v[i]=='['||v[i]=='{'){
+                            size_t close=find_close(i,t.depth+1);
+                            if(close==npos||close>=end)return false;
+                            if(close-i>=(t.close-t.open)/10*9){
+                                child={i,close,t.depth+1,v[i]=='{'};
+                                return true;
+                            }
+                            i=close+1;
+                        }else{
+                            p.i=i;
+                            p.get_element();
+                            i=p.i;
+                        }
+                        skip_whitespace(v,i);
+                        if(i>=end)return false;
+                        expect_char(v,i,',');
+                        i++;
+                    }
+                }
+                
+                //parses the members of one run with the sequential parser, the input is cut at the run's end so nothing past it is read
+                void parse_run(const target &t,run &r,const ParseOptions &inner) const {
+                    std::string_view v=data.substr(0,r.end);
+                    std::string scratch;
+                    ElementBuilder b;
+                    Parser<ElementBuilder> p(v,b,0,inner);
+                    size_t i=r.begin;
+                    while(true){
+                        skip_whitespace(v,i);
+                        if(i>=r.end)break;
+                        if(t.object){
+                            std::string_view key=read_string(v,i,scratch,options.strict_strings);
+                            if(key.size()>options.max_string_length) throw std::runtime_error("String length "+std::to_string(key.size())+" exceeds the maximum of "+std::to_string(options.max_string_length)+" at pos "+std::to_string(i));
+                            r.keys.emplace_back(key);
+                            skip_whitespace(v,i);
+                            expect_char(v,i,':');
+                            i++;
+                        }
+                        p.i=i;
+                        p.get_element();
+                        r.values.push_back(b.take());
+                        i=p.i;
+                        skip_whitespace(v,i);
+                        r.trailing_comma=false;
+                        if(i>=r.end)break;
+                        expect_char(v,i,',');
+                        i++;
+                        r.trailing_comma=true;
+                    }
+                }
+                
+                //joins the runs, checking what the sequential parser checks across them: no empty members, one trailing comma at most, and the member limit
+                bool assemble(const target &t,std::vector<run> &runs,Element &out) const {
+                    size_t total=0;
+                    for(size_t j=0;j<runs.size();j++){
+                        bool last=j+1==runs.size();
+                        if(runs[j].values.empty()&&!(last&&(j==0||!runs[j-1].trailing_comma)))return false;
+                        if(!last&&runs[j].trailing_comma)return false;
+                        total+=runs[j].values.size();
+                    }
+                    if(total>options.max_members)return false;
+                    if(t.object){
+                        Element::object_t members;
+                        for(run &r:runs){
+                            for(size_t j=0;j<r.values.size();j++){
+                                members.try_emplace(std::move(r.keys[j]),std::move(r.values[j]));//first occurrence of a duplicate key wins
+                            }
+                        }
+                        out=Object(std::move(members));
+                    }else{
+                        std::vector<Element> elements;
+                        elements.reserve(total);
+                        for(run &r:runs){
+                            std::move(r.values.begin(),r.values.end(),std::back_inserter(elements));
+                        }
+                        out=Array(std::move(elements));
+                    }
+                    return true;
+                }
+                
+                //the placeholder string, if it occurs exactly once in the tree
+                static Element * find_placeholder(Element &root,const std::string &marker){
+                    Element *found=nullptr;
+                    size_t count=0;
+                    std::vector<Element*> stack{&root};
+                    while(!stack.empty()){
+                        Element *e=stack.back();
+                        stack.pop_back();
+                        if(e->is_str()&&e->get_str()==marker){
+                            found=e;
+                            count++;
+                        }else if(e->is_arr()){
+                            for(Element &c:e->get_arr())stack.push_back(&c);
+                        }else if(e->is_obj()){
+                            for(auto &c:e->get_obj())stack.push_back(&c.second);
+                        }
+                    }
+                    return count==1?found:nullptr;
+                }
+        };
+        
+    }
+    
+    Element parse_parallel(std::string_view data,const ParseOptions &options,const ParallelParseOptions &parallel){
+        size_t threads=parallel.threads?parallel.threads:default_threads();
+        size_t chunk_size=std::max<size_t>(parallel.chunk_size,1);
+        if(threads>1&&data.size()/chunk_size>=2&&data.size()<=options.max_size){
+            try{
+                ParallelParser p(data,options,threads,chunk_size);
+                Element result;
+                if(p.parse(result))return result;
+            }catch(const std::exception &){
+                //invalid somewhere, the sequential parse below throws the same error it always would
+            }
+        }
+        return parse(data,options);
+    }
+
+}
@@ -0,0 +1,582 @@
+#pragma once
+
+//internal grammar shared by the parsers in src/, not part of the public interface
+
+#include "json.h"
+#include "json_number.h"
+#include "json_scan.h"
+#include "json_stats.h"
+#include <chrono>
+#include <map>
+#include <string_view>
+#include <stdexcept>
+
+namespace JSON {
+    
+    namespace internal {
+        
+        constexpr bool is_whitespace(char c){
+            return c==' '||c=='\t'||c=='\r'||c=='\n';
+        }
+        
+        constexpr bool is_word_start(char c){
+            return (c>='a'&&c<='z')||(c>='A'&&c<='Z')||c=='_';
+        }
+        
+        constexpr bool is_number(char c){
+            return (c>='0'&&c<='9');
+        }
+        
+        constexpr bool is_word_char(char c){
+            return (c>='a'&&c<='z')||(c>='A'&&c<='Z')||(c>='0'&&c<='9')||c=='_';
+        }
+        
+        inline bool is_number_start_nosign(std::string_view data, size_t i){
+            return is_number(data[i])||(data[i]=='.'&&(i+1<data.size())&&is_number(data[i+1]));
+        }
+        
+        inline bool is_number_start(std::string_view data, size_t i){
+            return is_number_start_nosign(data,i)||((data[i]=='-'||data[i]=='+')&&(i+1<data.size())&&is_number_start_nosign(data,i+1));
+        }
+        
+        constexpr char unescape(char c){
+            switch(c) {
+            case 'a':
+                return '\a';
+            case 'b':
+                return '\b';
+            case 'e':
+                return '\e';
+            case 'f':
+                return '\f';
+            case 'n':
+                return '\n';
+            case 'r':
+                return '\r';
+            case 't':
+                return '\t';
+            case 'v':
+                return '\v';
+            case '\\':
+                return '\\';
+            case '"':
+                return '\"';
+            default:
+                return c;
+            }
+        }
+        
+        //short escapes that are written on output, other control characters are written as \u00XX
+        constexpr char escape(char c){
+            switch(c) {
+            case '\b':
+                return 'b';
+            case '\f':
+                return 'f';
+            case '\n':
+                return 'n';
+            case '\r':
+                return 'r';
+            case '\t':
+                return 't';
+            case '\\':
+                return '\\';
+            case '"':
+                return '"';
+            default:
+                return c;
+            }
+        }
+        
+        //escapes allowed by RFC 8259, unescape also takes \a, \e, \v and any other character (as itself) in lenient mode
+        constexpr bool is_rfc_escape(char c){
+            return c=='"'||c=='\\'||c=='/'||c=='b'||c=='f'||c=='n'||c=='r'||c=='t'||c=='u';
+        }
+        
+        inline std::string escape_char_str(char c){
+            if(c=='\\'||c=='"'||escape(c)!=c){
+                return std::string{'\\',escape(c)};
+            }else{
+                return std::string(1,c);
+            }
+        }
+        
+        //value of the 4 hex digits at s[j], false if there aren't 4 of them
+        inline bool read_hex4(std::string_view s,size_t j,uint32_t &v){
+            if(j+4>s.size())return false;
+            v=0;
+            for(size_t k=j;k<j+4;k++){
+                char c=s[k];
+                uint32_t d;
+                if(c>='0'&&c<='9')d=c-'0';
+                else if(c>='a'&&c<='f')d=c-'a'+10;
+                else if(c>='A'&&c<='F')d=c-'A'+10;
+                else return false;
+                v=(v<<4)|d;
+            }
+            return true;
+        }
+        
+        inline void append_utf8(std::string &out,uint32_t cp){
+            if(cp<0x80){
+                out+=static_cast<char>(cp);
+            }else if(cp<0x800){
+                out+=static_cast<char>(0xc0|(cp>>6));
+                out+=static_cast<char>(0x80|(cp&0x3f));
+            }else if(cp<0x10000){
+                out+=static_cast<char>(0xe0|(cp>>12));
+                out+=static_cast<char>(0x80|((cp>>6)&0x3f));
+                out+=static_cast<char>(0x80|(cp&0x3f));
+            }else{
+                out+=static_cast<char>(0xf0|(cp>>18));
+                out+=static_cast<char>(0x80|((cp>>12)&0x3f));
+                out+=static_cast<char>(0x80|((cp>>6)&0x3f));
+                out+=static_cast<char>(0x80|(cp&0x3f));
+            }
+        }
+        
+        //decodes the UTF-8 sequence at s[j], returns its length, or 0 if it's invalid (overlong, a surrogate, above U+10FFFF or truncated)
+        inline size_t decode_utf8(std::string_view s,size_t j,uint32_t &cp){
+            auto byte=[&](size_t k){ return static_cast<uint8_t>(s[k]); };
+            uint8_t c=byte(j);
+            size_t len;
+            uint32_t min;
+            if(c<0x80){
+                cp=c;
+                return 1;
+            }else if(c>=0xc2&&c<=0xdf){
+                len=2;
+                min=0x80;
+                cp=c&0x1f;
+            }else if(c>=0xe0&&c<=0xef){
+                len=3;
+                min=0x800;
+                cp=c&0x0f;
+            }else if(c>=0xf0&&c<=0xf4){
+                len=4;
+                min=0x10000;
+                cp=c&0x07;
+            }else{
+                return 0;
+            }
+            if(j+len>s.size())return 0;
+            for(size_t k=j+1;k<j+len;k++){
+                if((byte(k)&0xc0)!=0x80)return 0;
+                cp=(cp<<6)|(byte(k)&0x3f);
+            }
+            if(cp<min||cp>0x10ffff||(cp>=0xd800&&cp<=0xdfff))return 0;
+            return len;
+        }
+        
+        inline void append_u_escape(std::string &out,uint32_t u){
+            const char * digits="0123456789abcdef";
+            out+="\\u";
+            out+=digits[(u>>12)&0xf];
+            out+=digits[(u>>8)&0xf];
+            out+=digits[(u>>4)&0xf];
+            out+=digits[u&0xf];
+        }
+        
+        //writes s as a quoted string literal, escaping only what has to be escaped, runs that don't need escaping are found with the vectorized scan and copied whole
+        //with ascii_only everything outside ASCII is written as \uXXXX (surrogate pairs above U+FFFF), bytes that aren't valid UTF-8 become \ufffd
+        inline void append_quoted(std::string &out,std::string_view s,bool ascii_only=false){
+            out+='"';
+            size_t run=0;//start of the current run of characters that don't need escaping
+            size_t j=0;
+            while((j=ascii_only?find_escape_ascii(s,j):find_escape(s,j))<s.size()){
+                out.append(s.data()+run,j-run);
+                char c=s[j];
+                if(static_cast<uint8_t>(c)>=0x80){
+                    uint32_t cp;
+                    size_t len=decode_utf8(s,j,cp);
+                    if(len==0){
+                        cp=0xfffd;
+                        len=1;
+                    }
+                    if(cp>=0x10000){
+                        append_u_escape(out,0xd800+((cp-0x10000)>>10));
+                        append_u_escape(out,0xdc00+((cp-0x10000)&0x3ff));
+                    }else{
+                        append_u_escape(out,cp);
+                    }
+                    j+=len;
+                }else{
+                    if(c=='\\'||c=='"'||escape(c)!=c){
+                        out+='\\';
+                        out+=escape(c);
+                    }else{
+                        append_u_escape(out,static_cast<uint8_t>(c));
+                    }
+                    j++;
+                }
+                run=j;
+            }
+            out.append(s.data()+run,s.size()-run);
+            out+='"';
+        }
+        
+        inline void expect_char(std::string_view data, size_t &i,char c){
+            if(i>=data.size()) throw std::runtime_error("Expected '"+escape_char_str(c)+"', got EOF");
+            if(data[i]!=c) throw std::runtime_error("Expected '"+escape_char_str(c)+"', got '"+data[i]+"' at pos "+std::to_string(i));
+        }
+        
+        //decodes the body of a string literal (without the quotes), raw newlines are dropped and escapes are resolved, \uXXXX (and surrogate pairs) to UTF-8
+        //lenient mode keeps unknown escapes as the character itself and replaces unpaired surrogates with U+FFFD, strict mode throws for both
+        //pos is where body starts in the document, for error messages
+        inline void decode_string(std::string_view body,std::string &out,bool strict=false,size_t pos=0){
+            out.clear();
+            out.reserve(body.size());
+            size_t run=0;//start of the current run of characters that are copied as-is
+            for(size_t j=0;j<body.size();j++){
+                if(body[j]=='\n'||body[j]=='\\'){
+                    out.append(body.data()+run,j-run);
+                    if(body[j]=='\\'){
+                        size_t escape_pos=j;
+                        j++;
+                        if(strict&&!is_rfc_escape(body[j])) throw std::runtime_error("Invalid escape '\\"+std::string(1,body[j])+"' at pos "+std::to_string(pos+escape_pos));
+                        uint32_t cp;
+                        if(body[j]!='u'){
+                            out+=unescape(body[j]);
+                        }else if(read_hex4(body,j+1,cp)){
+                            j+=4;
+                            uint32_t low;
+                            if(cp>=0xd800&&cp<=0xdbff&&j+2<body.size()&&body[j+1]=='\\'&&body[j+2]=='u'&&read_hex4(body,j+3,low)&&low>=0xdc00&&low<=0xdfff){
+                                cp=0x10000+((cp-0xd800)<<10)+(low-0xdc00);
+                                j+=6;
+                            }else if(cp>=0xd800&&cp<=0xdfff){
+                                if(strict) throw std::runtime_error("Unpaired surrogate '\\"+std::string(body.substr(escape_pos+1,5))+"' at pos "+std::to_string(pos+escape_pos));
+                                cp=0xfffd;
+                            }
+                            append_utf8(out,cp);
+                        }else{
+                            if(strict) throw std::runtime_error("Expected 4 hex digits after '\\u' at pos "+std::to_string(pos+escape_pos));
+                            out+='u';
+                        }
+                    }
+                    run=j+1;
+                }
+            }
+            out.append(body.data()+run,body.size()-run);
+        }
+        
+        //reads the string literal at i and moves i past it
+        //returns a view into data if the string has no escapes, or into scratch otherwise
+        //strict mode follows RFC 8259: UTF-8 is validated and raw control characters are rejected, in the same scan that looks for the closing quote
+        inline std::string_view read_string(std::string_view data,size_t &i,std::string &scratch,bool strict=false){
+            expect_char(data,i,'"');
+            i++;
+            size_t start=i;
+            bool plain=true;
+            while((i=strict?find_escape_ascii(data,i):find_string_special(data,i))<data.size()){
+                uint8_t c=static_cast<uint8_t>(data[i]);
+                if(c=='\\'){
+                    i+=2;
+                    plain=false;
+                }else if(c=='"'){
+                    std::string_view body=data.substr(start,i-start);
+                    i++;
+                    if(plain)return body;
+                    decode_string(body,scratch,strict,start);
+                    return scratch;
+                }else if(!strict){
+                    i++;//raw newline
+                    plain=false;
+                }else if(c<0x20){
+                    throw std::runtime_error("Unescaped control character in string at pos "+std::to_string(i));
+                }else{
+                    //not ASCII, validated one sequence at a time until the string is back to ASCII
+                    uint32_t cp;
+                    do{
+                        size_t len=decode_utf8(data,i,cp);
+                        if(len==0) throw std::runtime_error("Invalid UTF-8 in string at pos "+std::to_string(i));
+                        i+=len;
+                    }while(i<data.size()&&static_cast<uint8_t>(data[i])>=0x80);
+                }
+            }
+            throw std::runtime_error("Expected '\"', got EOF");
+        }
+        
+        inline void skip_whitespace(std::string_view data, size_t &i){ //SAFE TO CALL ON EOF, also skips comments
+            while(i<data.size()){
+                if(is_whitespace(data[i])){
+                    i=skip_whitespace_run(data,i+1);
+                }else if(data[i]=='/'&&(i+1<data.size())&&(data[i+1]=='/'||data[i+1]=='*')){
+                    if(data[i+1]=='/'){
+                        i+=2;
+                        while(i<data.size()&&data[i]!='\n')i++;
+                        if(i<data.size())i++;
+                    }else{
+                        i+=2;
+                        while(i<data.size()&&!(data[i]=='*'&&(i+1<data.size())&&data[i+1]=='/'))i++;
+                        i=std::min(i+2,data.size());
+                    }
+                }else{
+                    break;
+                }
+            }
+        }
+        
+        //adds the time until it goes out of scope to one of the counters of a stats struct, compiles to nothing when enabled is false
+        template<bool enabled,typename S>
+        struct phase_timer {
+            inline phase_timer(S*,uint64_t S::*){}
+        };
+        
+        template<typename S>
+        struct phase_timer<true,S> {
+            S * stats;
+            uint64_t S::*counter;
+            std::chrono::steady_clock::time_point start;
+            
+            inline phase_timer(S *s,uint64_t S::*c) : stats(s), counter(c), start(std::chrono::steady_clock::now()) {}
+            inline ~phase_timer(){ stats->*counter+=std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-start).count(); }
+        };
+        
+        //allocations a std::vector makes when n elements are added one at a time, its capacity doubles each time
+        inline void estimate_vector(size_t n,size_t element_size,size_t &allocations,size_t &bytes){
+            for(size_t cap=1;n;cap*=2){
+                allocations++;
+                bytes+=cap*element_size;
+                if(cap>=n)break;
+            }
+        }
+        
+        //allocations an object_t with n members makes when they're added one at a time
+        inline void estimate_object(size_t n,size_t &allocations,size_t &bytes){
+            using value_type = Element::object_t::value_type;
+            if constexpr(std::is_same_v<Element::object_t,std::map<std::string,Element>>){
+                allocations+=n;//one tree node per member
+                bytes+=n*(sizeof(value_type)+32);//plus the node's header
+            }else{
+                estimate_vector(n,sizeof(value_type),allocations,bytes);
+                for(size_t cap=32;n>8;cap*=2){//hash index, from the 9th member on
+                    allocations++;
+                    bytes+=cap*sizeof(uint32_t);
+                    if(cap>=n*2)break;
+                }
+            }
+        }
+        
+        //validates a value without storing anything
+        struct SkipHandler {
+            inline void on_object_start(){}
+            inline void on_key(std::string_view){}
+            inline void on_object_end(){}
+            inline void on_array_start(){}
+            inline void on_array_end(){}
+            inline void on_string(std::string_view){}
+            inline void on_int(int64_t){}
+            inline void on_double(double){}
+            inline void on_literal(JSON_Literal){}
+        };
+        
+        //reports the document's structure to a Handler-like object as it's read
+        //iterative, open containers are kept on an explicit stack, so nesting is only limited by ParseOptions::max_depth and not by the call stack
+        //with Stats, counts and phase times are added to *stats, which has to be set, without it none of that code is compiled in
+        template<typename H,bool Stats=false>
+        class Parser {
+            public:
+                std::string_view data;
+                size_t i;
+                size_t token_start=0;//position of the value or key being reported to the handler, valid in on_*_start, on_key and the scalar callbacks
+                size_t outer_depth=0;//containers already open around the parsed value, counted against ParseOptions::max_depth
+                ParseStats * stats=nullptr;
+                
+                inline Parser(std::string_view input,H &handler,size_t pos=0,const ParseOptions &opts=ParseOptions()) : data(input), i(pos), options(opts), h(handler) {}
+                
+                void get_element(){
+                    phase_timer<Stats,ParseStats> t(stats,&ParseStats::total_ns);
+                    size_t start=i;
+                    if(data.size()>options.max_size) throw std::runtime_error("Document size "+std::to_string(data.size())+" exceeds the maximum of "+std::to_string(options.max_size));
+                    stack.clear();
+                    while(true){
+                        get_value();
+                        //close finished containers until one has another value to read
+                        while(true){
+                            if(stack.empty()){
+                                if constexpr(Stats)stats->bytes+=i-start;
+                                return;
+                            }
+                            ws();
+                            frame &f=stack.back();
+                            char close=f.object?'}':']';
+                            if(i<data.size()&&data[i]==close){
+                                i++;
+                                end(f);
+                                continue;
+                            }
+                            expect_char(data,i,',');
+                            i++;
+                            ws();
+                            if(i<data.size()&&data[i]==close){
+                                i++;
+                                end(f);
+                                continue;
+                            }
+                            if(i>=data.size()) throw std::runtime_error(std::string("Expected '")+close+"', got EOF");
+                            next(f);
+                            break;
+                        }
+                    }
+                }
+            
+            private:
+                struct frame {
+                    bool object;
+                    size_t members;
+                };
+                
+                ParseOptions options;
+                H &h;
+                std::string scratch;//holds decoded strings that contain escapes, reused between strings
+                std::vector<frame> stack;//open containers, reused between documents
+                
+                inline void ws(){
+                    phase_timer<Stats,ParseStats> t(stats,&ParseStats::whitespace_ns);
+                    skip_whitespace(data,i);
+                }
+                
+                //runs a handler callback, timed as building
+                template<typename F>
+                inline void build(F &&f){
+                    phase_timer<Stats,ParseStats> t(stats,&ParseStats::build_ns);
+                    f();
+                }
+                
+                inline void count(size_t ParseStats::*counter){
+                    if constexpr(Stats)(stats->*counter)++;
+                }
+                
+                //returns a view into the input if the string has no escapes, or into scratch otherwise, only valid until the next call
+                inline std::string_view get_string(){
+                    phase_timer<Stats,ParseStats> t(stats,&ParseStats::string_ns);
+                    size_t start=i;
+                    std::string_view s=read_string(data,i,scratch,options.strict_strings);
+                    if(s.size()>options.max_string_length) throw std::runtime_error("String length "+std::to_string(s.size())+" exceeds the maximum of "+std::to_string(options.max_string_length)+" at pos "+std::to_string(i));
+                    if constexpr(Stats){
+                        if(s.data()==scratch.data()){
+                            for(size_t j=start+1;j<i-1;j++){
+                                if(data[j]=='\\'){
+                                    stats->escapes++;
+                                    j++;
+                                }
+                            }
+                        }
+                        if(s.size()>15){//longer than the small string buffer
+                            stats->allocations++;
+                            stats->allocated_bytes+=s.size()+1;
+                        }
+                    }
+                    return s;
+                }
+                
+                //counts a new member of the innermost container, and reads its key if it's an object
+                inline void next(frame &f){
+                    if(++f.members>options.max_members) throw std::runtime_error("Container has more than the maximum of "+std::to_string(options.max_members)+" members at pos "+std::to_string(i));
+                    if(f.object){
+                        token_start=i;
+                        count(&ParseStats::keys);
+                        std::string_view key=get_string();
+                        build([&]{ h.on_key(key); });
+                        ws();
+                        expect_char(data,i,':');
+                        i++;
+                    }
+                }
+                
+                inline void end(const frame &f){
+                    if(f.object){
+                        build([&]{ h.on_object_end(); });
+                        if constexpr(Stats)estimate_object(f.members,stats->allocations,stats->allocated_bytes);
+                    }else{
+                        build([&]{ h.on_array_end(); });
+                        if constexpr(Stats)estimate_vector(f.members,sizeof(Element),stats->allocations,stats->allocated_bytes);
+                    }
+                    stack.pop_back();
+                }
+                
+                //opens a container, the first member (and its key) is read if it isn't empty
+                void open(bool object){
+                    if(outer_depth+stack.size()>=options.max_depth) throw std::runtime_error("Maximum depth of "+std::to_string(options.max_depth)+" exceeded at pos "+std::to_string(i));
+                    char close=object?'}':']';
+                    i++;
+                    if(object){
+                        count(&ParseStats::objects);
+                        build([&]{ h.on_object_start(); });
+                    }else{
+                        count(&ParseStats::arrays);
+                        build([&]{ h.on_array_start(); });
+                    }
+                    stack.push_back({object,0});
+                    if constexpr(Stats)stats->max_depth=std::max(stats->max_depth,stack.size());
+                    ws();
+                    if(i<data.size()&&data[i]==close){
+                        i++;
+                        end(stack.back());
+                        return;
+                    }
+                    if(i>=data.size()) throw std::runtime_error(std::string("Expected '")+close+"', got EOF");
+                    next(stack.back());
+                }
+                
+                inline void literal(JSON_Literal l,size_t length){
+                    i+=length;
+                    count(&ParseStats::literals);
+                    build([&]{ h.on_literal(l); });
+                }
+                
+                //reads a scalar, or opens a container, in which case get_element's loop carries on with its first member
+                //returns once there is a complete value or a new open container with a value to read
+                void get_value(){
+                    while(true){
+                        ws();
+                        if(i>=data.size()) throw std::runtime_error("Expected JSON, got EOF");
+                        token_start=i;
+                        switch(data[i]){
+                        case '[':
+                        case '{':{
+                            size_t depth=stack.size();
+                            open(data[i]=='{');
+                            if(stack.size()>depth)continue;//not empty, read the first member
+                            return;
+                        }
+                        case '"':{
+                            count(&ParseStats::strings);
+                            std::string_view s=get_string();
+                            build([&]{ h.on_string(s); });
+                            return;
+                        }
+                        default:
+                            if(is_number_start(data,i)){
+                                Number n;
+                                {
+                                    phase_timer<Stats,ParseStats> t(stats,&ParseStats::number_ns);
+                                    n=get_number(data,i);
+                                }
+                                if(n.is_double){
+                                    count(&ParseStats::doubles);
+                                    build([&]{ h.on_double(n.d); });
+                                }else{
+                                    count(&ParseStats::ints);
+                                    build([&]{ h.on_int(n.i); });
+                                }
+                                return;
+                            }else if((i+3)<data.size()&&data[i]=='n'&&data[i+1]=='u'&&data[i+2]=='l'&&data[i+3]=='l'){
+                                literal(JSON_NULL,4);
+                                return;
+                            }else if((i+3)<data.size()&&data[i]=='t'&&data[i+1]=='r'&&data[i+2]=='u'&&data[i+3]=='e'){
+                                literal(JSON_TRUE,4);
+                                return;
+                            }else if((i+4)<data.size()&&data[i]=='f'&&data[i+1]=='a'&&data[i+2]=='l'&&data[i+3]=='s'&&data[i+4]=='e'){
+                                literal(JSON_FALSE,5);
+                                return;
+                            }
+                        }
+                        throw std::runtime_error(std::string("Expected JSON, got '")+data[i]+"' at pos "+std::to_string(i));
+                    }
+                }
+        };
+        
+    }
+
+}
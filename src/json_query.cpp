@@ -0,0 +1,306 @@
+#include "json_query.h"
+#include "json_parser.h"
+#include <algorithm>
+
+namespace JSON {
+    
+    using namespace internal;
+    
+    namespace {
+        
+        //splits a pointer into unescaped reference tokens
+        std::vector<std::string> split_pointer(const std::string &pointer){
+            std::vector<std::string> tokens;
+            if(pointer.empty())return tokens;
+            if(pointer[0]!='/') throw std::invalid_argument("JSON Pointer '"+pointer+"' doesn't start with '/'");
+            for(size_t i=0;i<pointer.size();){
+                std::string token;
+                for(i++;i<pointer.size()&&pointer[i]!='/';i++){
+                    if(pointer[i]=='~'){
+                        if(i+1<pointer.size()&&(pointer[i+1]=='0'||pointer[i+1]=='1')){
+                            token+=pointer[++i]=='0'?'~':'/';
+                        }else{
+                            throw std::invalid_argument("JSON Pointer '"+pointer+"' has an invalid '~' escape at pos "+std::to_string(i));
+                        }
+                    }else{
+                        token+=pointer[i];
+                    }
+                }
+                tokens.push_back(std::move(token));
+            }
+            return tokens;
+        }
+        
+        //array index of a reference token, no leading zeros allowed
+        bool token_index(const std::string &token,size_t &index){
+            if(token.empty()||token.size()>18||(token.size()>1&&token[0]=='0'))return false;
+            index=0;
+            for(char c:token){
+                if(!is_number(c))return false;
+                index=index*10+(c-'0');
+            }
+            return true;
+        }
+        
+    }
+    
+    Query::Query(const std::vector<std::string> &pointers) : nodes(1), pointer_count(pointers.size()) {
+        for(size_t p=0;p<pointers.size();p++){
+            std::vector<std::string> tokens=split_pointer(pointers[p]);
+            bool wildcard=std::find(tokens.begin(),tokens.end(),"*")!=tokens.end();
+            repeated.push_back(wildcard);
+            size_t n=0;
+            for(const std::string &token:tokens){
+                if(wildcard)nodes[n].open=true;
+                else nodes[n].fixed++;
+                auto it=std::find_if(nodes[n].keys.begin(),nodes[n].keys.end(),[&](const auto &k){ return k.first==token; });
+                if(it!=nodes[n].keys.end()){
+                    n=it->second;
+                    continue;
+                }
+                size_t child=nodes.size();
+                nodes.emplace_back();
+                nodes[child].parent=n;
+                nodes[n].keys.emplace_back(token,child);
+                size_t index;
+                if(token=="*"){
+                    nodes[n].wildcard=child;
+                }else if(token_index(token,index)){
+                    nodes[n].indices.emplace_back(index,child);
+                }
+                n=child;
+            }
+            if(wildcard)nodes[n].open=true;
+            else nodes[n].fixed++;
+            nodes[n].targets.push_back(p);
+        }
+    }
+    
+    //walks one document, descending only into members and elements that some pointer goes through
+    class QueryRunner {
+        public:
+            inline QueryRunner(const Query &q,std::string_view d) : query(q), data(d), results(q.pointer_count), found(q.pointer_count,false) {
+                remaining.reserve(q.nodes.size());
+                for(const Query::node &n:q.nodes)remaining.push_back(n.fixed);
+            }
+            
+            std::vector<std::vector<Element>> run(){
+                size_t i=0;
+                value(0,i);
+                return std::move(results);
+            }
+        
+        private:
+            const Query &query;
+            std::string_view data;
+            std::vector<std::vector<Element>> results;
+            std::vector<bool> found;//pointers without a wildcard that already matched
+            std::vector<size_t> remaining;//unmatched pointers without a wildcard below each node
+            std::string scratch;
+            
+            inline bool exhausted(size_t n) const {
+                return !query.nodes[n].open&&remaining[n]==0;
+            }
+            
+            inline bool done() const {
+                return exhausted(0);
+            }
+            
+            inline bool has_children(size_t n) const {
+                return !query.nodes[n].keys.empty();
+            }
+            
+            //the value at i is what node n points to, on return i is past the value unless the whole run is done
+            void value(size_t n,size_t &i){
+                skip_whitespace(data,i);
+                const Query::node &nd=query.nodes[n];
+                if(nd.targets.empty()){
+                    children(n,i);
+                    return;
+                }
+                size_t start=i;
+                ElementBuilder b;
+                Parser<ElementBuilder> p(data,b,i);
+                p.get_element();
+                i=p.i;
+                Element e=b.take();
+                for(size_t t:nd.targets){
+                    if(query.repeated[t]){
+                        results[t].push_back(e);
+                    }else if(!found[t]){
+                        found[t]=true;
+                        results[t].push_back(e);
+                        for(size_t m=n;m!=Query::npos;m=query.nodes[m].parent)remaining[m]--;
+                    }
+                }
+                if(has_children(n)&&!exhausted(n)){
+                    children(n,start);//already validated by the parser above, so i stays where the parser left it
+                }
+            }
+            
+            void children(size_t n,size_t &i){
+                const Query::node &nd=query.nodes[n];
+                if(i<data.size()&&data[i]=='{'&&has_children(n)){
+                    walk_object(n,i);
+                }else if(i<data.size()&&data[i]=='['&&(nd.wildcard!=Query::npos||!nd.indices.empty())){
+                    walk_array(n,i);
+                }else{
+                    skip_value(i);
+                }
+            }
+            
+            void walk_object(size_t n,size_t &i){
+                const Query::node &nd=query.nodes[n];
+                std::vector<size_t> visited;//child nodes already matched in this object, later duplicate keys are ignored
+                i++;
+                skip_whitespace(data,i);
+                if(i<data.size()&&data[i]=='}'){
+                    i++;
+                    return;
+                }
+                while(i<data.size()){
+                    std::string_view key=read_string(data,i,scratch);
+                    size_t child=Query::npos;
+                    for(const auto &k:nd.keys){
+                        if(k.first==key){
+                            child=k.second;
+                            break;
+                        }
+                    }
+                    skip_whitespace(data,i);
+                    expect_char(data,i,':');
+                    i++;
+                    if(child!=Query::npos&&std::find(visited.begin(),visited.end(),child)==visited.end()&&!exhausted(child)){
+                        visited.push_back(child);
+                        value(child,i);
+                        if(done())return;
+                    }else{
+                        if(child!=Query::npos)visited.push_back(child);
+                        skip_value(i);
+                    }
+                    if(exhausted(n)){
+                        skip_nested(i,1,'}');
+                        return;
+                    }
+                    skip_whitespace(data,i);
+                    if(i<data.size()&&data[i]=='}'){
+                        i++;
+                        return;
+                    }
+                    expect_char(data,i,',');
+                    i++;
+                    skip_whitespace(data,i);
+                    if(i<data.size()&&data[i]=='}'){
+                        i++;
+                        return;
+                    }
+                }
+                throw std::runtime_error("Expected '}', got EOF");
+            }
+            
+            void walk_array(size_t n,size_t &i){
+                const Query::node &nd=query.nodes[n];
+                i++;
+                skip_whitespace(data,i);
+                if(i<data.size()&&data[i]==']'){
+                    i++;
+                    return;
+                }
+                for(size_t index=0;i<data.size();index++){
+                    size_t child=Query::npos;
+                    for(const auto &k:nd.indices){
+                        if(k.first==index){
+                            child=k.second;
+                            break;
+                        }
+                    }
+                    size_t start=i;
+                    if(child!=Query::npos&&!exhausted(child)){
+                        value(child,i);
+                        if(done())return;
+                    }
+                    if(nd.wildcard!=Query::npos){
+                        size_t j=start;//the element may be matched by both an index and the wildcard
+                        value(nd.wildcard,j);
+                        if(done())return;
+                        i=j;
+                    }else if(i==start){
+                        skip_value(i);
+                    }
+                    if(exhausted(n)){
+                        skip_nested(i,1,']');
+                        return;
+                    }
+                    skip_whitespace(data,i);
+                    if(i<data.size()&&data[i]==']'){
+                        i++;
+                        return;
+                    }
+                    expect_char(data,i,',');
+                    i++;
+                    skip_whitespace(data,i);
+                    if(i<data.size()&&data[i]==']'){
+                        i++;
+                        return;
+                    }
+                }
+                throw std::runtime_error("Expected ']', got EOF");
+            }
+            
+            //skips a value nobody asked for, containers are only checked for balanced brackets
+            void skip_value(size_t &i){
+                skip_whitespace(data,i);
+                if(i>=data.size()) throw std::runtime_error("Expected JSON, got EOF");
+                switch(data[i]){
+                case '{':
+                    skip_nested(++i,1,'}');
+                    return;
+                case '[':
+                    skip_nested(++i,1,']');
+                    return;
+                case '"':
+                    read_string(data,i,scratch);
+                    return;
+                default:
+                    size_t start=i;
+                    while(i<data.size()&&!is_whitespace(data[i])&&data[i]!=','&&data[i]!=']'&&data[i]!='}'&&data[i]!='/')i++;
+                    if(i==start) throw std::runtime_error(std::string("Expected JSON, got '")+data[i]+"' at pos "+std::to_string(i));
+                }
+            }
+            
+            //moves i past the end of depth levels of nesting, closer is the bracket that ends the outermost one
+            void skip_nested(size_t &i,size_t depth,char closer){
+                while(depth){
+                    i=find_structural(data,i);
+                    if(i>=data.size()) throw std::runtime_error(std::string("Expected '")+closer+"', got EOF");
+                    switch(data[i]){
+                    case '"':
+                        read_string(data,i,scratch);
+                        break;
+                    case '/':
+                        if(i+1<data.size()&&(data[i+1]=='/'||data[i+1]=='*')){
+                            skip_whitespace(data,i);
+                        }else{
+                            i++;
+                        }
+                        break;
+                    case '[':
+                    case '{':
+                        depth++;
+                        i++;
+                        break;
+                    default:
+                        depth--;
+                        i++;
+                        break;
+                    }
+                }
+            }
+    };
+    
+    std::vector<std::vector<Element>> Query::run(std::string_view data) const {
+        QueryRunner r(*this,data);
+        return r.run();
+    }
+
+}
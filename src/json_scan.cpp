@@ -0,0 +1,268 @@
+#include "json_scan.h"
+
+#if defined(__x86_64__)||defined(_M_X64)
+#define JSON_SCAN_X86 1
+#include <immintrin.h>
+#else
+#define JSON_SCAN_X86 0
+#endif
+
+namespace JSON {
+    
+    namespace internal {
+        
+        namespace {
+            
+            constexpr bool is_ws(char c){
+                return c==' '||c=='\t'||c=='\r'||c=='\n';
+            }
+            
+            constexpr bool is_string_special(char c){
+                return c=='"'||c=='\\'||c=='\n';
+            }
+            
+            constexpr bool is_structural(char c){
+                return c=='"'||c=='['||c==']'||c=='{'||c=='}'||c=='/';
+            }
+            
+            constexpr bool is_separator(char c){
+                return is_structural(c)||c==',';
+            }
+            
+            constexpr bool is_digit(char c){
+                return c>='0'&&c<='9';
+            }
+            
+            constexpr bool is_escape(char c){
+                return c=='"'||c=='\\'||static_cast<unsigned char>(c)<0x20;
+            }
+            
+            constexpr bool is_escape_ascii(char c){
+                return c=='"'||c=='\\'||static_cast<unsigned char>(c)<0x20||static_cast<unsigned char>(c)>=0x80;
+            }
+            
+            size_t whitespace_scalar(const char * data,size_t i,size_t n){
+                while(i<n&&is_ws(data[i]))i++;
+                return i;
+            }
+            
+            size_t string_special_scalar(const char * data,size_t i,size_t n){
+                while(i<n&&!is_string_special(data[i]))i++;
+                return i;
+            }
+            
+            size_t structural_scalar(const char * data,size_t i,size_t n){
+                while(i<n&&!is_structural(data[i]))i++;
+                return i;
+            }
+            
+            size_t separator_scalar(const char * data,size_t i,size_t n){
+                while(i<n&&!is_separator(data[i]))i++;
+                return i;
+            }
+            
+            size_t digits_scalar(const char * data,size_t i,size_t n){
+                while(i<n&&is_digit(data[i]))i++;
+                return i;
+            }
+            
+            size_t escape_scalar(const char * data,size_t i,size_t n){
+                while(i<n&&!is_escape(data[i]))i++;
+                return i;
+            }
+            
+            size_t escape_ascii_scalar(const char * data,size_t i,size_t n){
+                while(i<n&&!is_escape_ascii(data[i]))i++;
+                return i;
+            }
+            
+            #if JSON_SCAN_X86
+            
+            //sse2 is part of the x86-64 baseline, so it doesn't need a runtime check
+            
+            inline __m128i load16(const char * p){
+                return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            }
+            
+            inline __m128i eq16(__m128i v,char c){
+                return _mm_cmpeq_epi8(v,_mm_set1_epi8(c));
+            }
+            
+            inline unsigned mask16(__m128i v){
+                return static_cast<unsigned>(_mm_movemask_epi8(v));
+            }
+            
+            size_t whitespace_sse2(const char * data,size_t i,size_t n){
+                for(;i+16<=n;i+=16){
+                    __m128i v=load16(data+i);
+                    unsigned m=~mask16(_mm_or_si128(_mm_or_si128(eq16(v,' '),eq16(v,'\n')),_mm_or_si128(eq16(v,'\t'),eq16(v,'\r'))))&0xFFFF;
+                    if(m)return i+__builtin_ctz(m);
+                }
+                return whitespace_scalar(data,i,n);
+            }
+            
+            size_t string_special_sse2(const char * data,size_t i,size_t n){
+                for(;i+16<=n;i+=16){
+                    __m128i v=load16(data+i);
+                    unsigned m=mask16(_mm_or_si128(_mm_or_si128(eq16(v,'"'),eq16(v,'\\')),eq16(v,'\n')));
+                    if(m)return i+__builtin_ctz(m);
+                }
+                return string_special_scalar(data,i,n);
+            }
+            
+            size_t structural_sse2(const char * data,size_t i,size_t n){
+                for(;i+16<=n;i+=16){
+                    __m128i v=load16(data+i);
+                    //'[' and ']' only differ from '{' and '}' in bit 0x20, so setting it folds both kinds of brackets together
+                    __m128i b=_mm_or_si128(v,_mm_set1_epi8(0x20));
+                    unsigned m=mask16(_mm_or_si128(_mm_or_si128(eq16(v,'"'),eq16(v,'/')),_mm_or_si128(eq16(b,'{'),eq16(b,'}'))));
+                    if(m)return i+__builtin_ctz(m);
+                }
+                return structural_scalar(data,i,n);
+            }
+            
+            size_t separator_sse2(const char * data,size_t i,size_t n){
+                for(;i+16<=n;i+=16){
+                    __m128i v=load16(data+i);
+                    __m128i b=_mm_or_si128(v,_mm_set1_epi8(0x20));
+                    __m128i quote_slash_comma=_mm_or_si128(_mm_or_si128(eq16(v,'"'),eq16(v,'/')),eq16(v,','));
+                    unsigned m=mask16(_mm_or_si128(quote_slash_comma,_mm_or_si128(eq16(b,'{'),eq16(b,'}'))));
+                    if(m)return i+__builtin_ctz(m);
+                }
+                return separator_scalar(data,i,n);
+            }
+            
+            size_t digits_sse2(const char * data,size_t i,size_t n){
+                for(;i+16<=n;i+=16){
+                    //digits are the only characters that are still <=9 after subtracting '0' as unsigned bytes
+                    __m128i d=_mm_sub_epi8(load16(data+i),_mm_set1_epi8('0'));
+                    unsigned m=~mask16(_mm_cmpeq_epi8(_mm_min_epu8(d,_mm_set1_epi8(9)),d))&0xFFFF;
+                    if(m)return i+__builtin_ctz(m);
+                }
+                return digits_scalar(data,i,n);
+            }
+            
+            size_t escape_sse2(const char * data,size_t i,size_t n){
+                for(;i+16<=n;i+=16){
+                    __m128i v=load16(data+i);
+                    __m128i control=_mm_cmpeq_epi8(_mm_min_epu8(v,_mm_set1_epi8(0x1f)),v);//unsigned v<=0x1f
+                    unsigned m=mask16(_mm_or_si128(_mm_or_si128(eq16(v,'"'),eq16(v,'\\')),control));
+                    if(m)return i+__builtin_ctz(m);
+                }
+                return escape_scalar(data,i,n);
+            }
+            
+            size_t escape_ascii_sse2(const char * data,size_t i,size_t n){
+                for(;i+16<=n;i+=16){
+                    __m128i v=load16(data+i);
+                    //bytes that aren't ASCII are negative as signed bytes, so one signed compare finds them and control characters
+                    __m128i low=_mm_cmplt_epi8(v,_mm_set1_epi8(0x20));
+                    unsigned m=mask16(_mm_or_si128(_mm_or_si128(eq16(v,'"'),eq16(v,'\\')),low));
+                    if(m)return i+__builtin_ctz(m);
+                }
+                return escape_ascii_scalar(data,i,n);
+            }
+            
+            #define JSON_AVX2 __attribute__((target("avx2")))
+            
+            JSON_AVX2 inline __m256i load32(const char * p){
+                return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            }
+            
+            JSON_AVX2 inline __m256i eq32(__m256i v,char c){
+                return _mm256_cmpeq_epi8(v,_mm256_set1_epi8(c));
+            }
+            
+            JSON_AVX2 inline unsigned mask32(__m256i v){
+                return static_cast<unsigned>(_mm256_movemask_epi8(v));
+            }
+            
+            JSON_AVX2 size_t whitespace_avx2(const char * data,size_t i,size_t n){
+                for(;i+32<=n;i+=32){
+                    __m256i v=load32(data+i);
+                    unsigned m=~mask32(_mm256_or_si256(_mm256_or_si256(eq32(v,' '),eq32(v,'\n')),_mm256_or_si256(eq32(v,'\t'),eq32(v,'\r'))));
+                    if(m)return i+__builtin_ctz(m);
+                }
+                return whitespace_sse2(data,i,n);
+            }
+            
+            JSON_AVX2 size_t string_special_avx2(const char * data,size_t i,size_t n){
+                for(;i+32<=n;i+=32){
+                    __m256i v=load32(data+i);
+                    unsigned m=mask32(_mm256_or_si256(_mm256_or_si256(eq32(v,'"'),eq32(v,'\\')),eq32(v,'\n')));
+                    if(m)return i+__builtin_ctz(m);
+                }
+                return string_special_sse2(data,i,n);
+            }
+            
+            JSON_AVX2 size_t structural_avx2(const char * data,size_t i,size_t n){
+                for(;i+32<=n;i+=32){
+                    __m256i v=load32(data+i);
+                    __m256i b=_mm256_or_si256(v,_mm256_set1_epi8(0x20));
+                    unsigned m=mask32(_mm256_or_si256(_mm256_or_si256(eq32(v,'"'),eq32(v,'/')),_mm256_or_si256(eq32(b,'{'),eq32(b,'}'))));
+                    if(m)return i+__builtin_ctz(m);
+                }
+                return structural_sse2(data,i,n);
+            }
+            
+            JSON_AVX2 size_t separator_avx2(const char * data,size_t i,size_t n){
+                for(;i+32<=n;i+=32){
+                    __m256i v=load32(data+i);
+                    __m256i b=_mm256_or_si256(v,_mm256_set1_epi8(0x20));
+                    __m256i quote_slash_comma=_mm256_or_si256(_mm256_or_si256(eq32(v,'"'),eq32(v,'/')),eq32(v,','));
+                    unsigned m=mask32(_mm256_or_si256(quote_slash_comma,_mm256_or_si256(eq32(b,'{'),eq32(b,'}'))));
+                    if(m)return i+__builtin_ctz(m);
+                }
+                return separator_sse2(data,i,n);
+            }
+            
+            JSON_AVX2 size_t digits_avx2(const char * data,size_t i,size_t n){
+                for(;i+32<=n;i+=32){
+                    __m256i d=_mm256_sub_epi8(load32(data+i),_mm256_set1_epi8('0'));
+                    unsigned m=~mask32(_mm256_cmpeq_epi8(_mm256_min_epu8(d,_mm256_set1_epi8(9)),d));
+                    if(m)return i+__builtin_ctz(m);
+                }
+                return digits_sse2(data,i,n);
+            }
+            
+            JSON_AVX2 size_t escape_avx2(const char * data,size_t i,size_t n){
+                for(;i+32<=n;i+=32){
+                    __m256i v=load32(data+i);
+                    __m256i control=_mm256_cmpeq_epi8(_mm256_min_epu8(v,_mm256_set1_epi8(0x1f)),v);
+                    unsigned m=mask32(_mm256_or_si256(_mm256_or_si256(eq32(v,'"'),eq32(v,'\\')),control));
+                    if(m)return i+__builtin_ctz(m);
+                }
+                return escape_sse2(data,i,n);
+            }
+            
+            JSON_AVX2 size_t escape_ascii_avx2(const char * data,size_t i,size_t n){
+                for(;i+32<=n;i+=32){
+                    __m256i v=load32(data+i);
+                    __m256i low=_mm256_cmpgt_epi8(_mm256_set1_epi8(0x20),v);
+                    unsigned m=mask32(_mm256_or_si256(_mm256_or_si256(eq32(v,'"'),eq32(v,'\\')),low));
+                    if(m)return i+__builtin_ctz(m);
+                }
+                return escape_ascii_sse2(data,i,n);
+            }
+            
+            #undef JSON_AVX2
+            
+            #endif
+            
+        }
+        
+        scan_functions select_scan(){
+            #if JSON_SCAN_X86
+            __builtin_cpu_init();
+            if(__builtin_cpu_supports("avx2")){
+                return {"avx2",whitespace_avx2,string_special_avx2,structural_avx2,separator_avx2,digits_avx2,escape_avx2,escape_ascii_avx2};
+            }
+            return {"sse2",whitespace_sse2,string_special_sse2,structural_sse2,separator_sse2,digits_sse2,escape_sse2,escape_ascii_sse2};
+            #else
+            return {"scalar",whitespace_scalar,string_special_scalar,structural_scalar,separator_scalar,digits_scalar,escape_scalar,escape_ascii_scalar};
+            #endif
+        }
+        
+    }
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+//internal vectorized scanning primitives, the implementation is picked once at startup based on what the cpu supports
+
+#include <cstddef>
+#include <string_view>
+
+namespace JSON {
+    
+    namespace internal {
+        
+        //all functions take a buffer, a start position and the buffer size, and return the position of the first match, or the buffer size if there is none
+        struct scan_functions {
+            const char * name;
+            size_t (*whitespace)(const char * data,size_t i,size_t n);//first character that isn't whitespace
+            size_t (*string_special)(const char * data,size_t i,size_t n);//first '"', '\\' or raw newline
+            size_t (*structural)(const char * data,size_t i,size_t n);//first '"', '[', ']', '{', '}' or '/'
+            size_t (*separator)(const char * data,size_t i,size_t n);//same as structural, plus ','
+            size_t (*digits)(const char * data,size_t i,size_t n);//first character that isn't a digit
+            size_t (*escape)(const char * data,size_t i,size_t n);//first '"', '\\' or control character, what has to be escaped when writing a string
+            size_t (*escape_ascii)(const char * data,size_t i,size_t n);//same as escape, plus the first byte that isn't ASCII
+        };
+        
+        //checks what the cpu supports, called once
+        scan_functions select_scan();
+        
+        //the table is built on first use rather than by a global's initializer, so parsing works during other translation units' static initialization
+        inline const scan_functions & scan(){
+            static const scan_functions table=select_scan();
+            return table;
+        }
+        
+        inline size_t skip_whitespace_run(std::string_view data,size_t i){
+            return scan().whitespace(data.data(),i,data.size());
+        }
+        
+        inline size_t find_string_special(std::string_view data,size_t i){
+            return scan().string_special(data.data(),i,data.size());
+        }
+        
+        inline size_t find_structural(std::string_view data,size_t i){
+            return scan().structural(data.data(),i,data.size());
+        }
+        
+        inline size_t find_separator(std::string_view data,size_t i){
+            return scan().separator(data.data(),i,data.size());
+        }
+        
+        inline size_t find_escape(std::string_view data,size_t i){
+            return scan().escape(data.data(),i,data.size());
+        }
+        
+        inline size_t find_escape_ascii(std::string_view data,size_t i){
+            return scan().escape_ascii(data.data(),i,data.size());
+        }
+        
+        inline size_t skip_digits(std::string_view data,size_t i){
+            return scan().digits(data.data(),i,data.size());
+        }
+        
+    }
+
+}
@@ -0,0 +1,180 @@
+#include "json_shared.h"
+#include "json_writer.h"
+#include <atomic>
+
+namespace JSON {
+    
+    using namespace internal;
+    
+    namespace {
+        
+        //passes each key and value of an object to f as rvalues, std::map keys are const so its nodes are extracted, the object is left empty
+        template<typename F>
+        void drain_members(std::map<std::string,Element> &m,F &&f){
+            while(!m.empty()){
+                auto node=m.extract(m.begin());
+                f(std::move(node.key()),std::move(node.mapped()));
+            }
+        }
+        
+        template<typename F>
+        void drain_members(ObjectMap<Element> &m,F &&f){
+            for(auto &c:m){
+                f(std::move(c.first),std::move(c.second));
+            }
+            m.clear();
+        }
+        
+    }
+    
+    SharedElement::SharedElement(std::string s) : data(std::make_shared<Node>(Node{std::move(s)})) {
+    }
+    
+    SharedElement::SharedElement(array_t a) : data(std::make_shared<Node>(Node{std::move(a)})) {
+    }
+    
+    SharedElement::SharedElement(object_t o) : data(std::make_shared<Node>(Node{std::move(o)})) {
+    }
+    
+    SharedElement::SharedElement(const Element &e){
+        if(e.is_int()){
+            data=e.get_int();
+        }else if(e.is_double()){
+            data=e.get_double();
+        }else if(e.is_lit()){
+            data=e.get_lit();
+        }else if(e.is_str()){
+            data=std::make_shared<Node>(Node{e.get_str()});
+        }else if(e.is_arr()){
+            array_t a;
+            a.reserve(e.get_arr().size());
+            for(const Element &c:e.get_arr()){
+                a.emplace_back(c);
+            }
+            data=std::make_shared<Node>(Node{std::move(a)});
+        }else{
+            object_t m;
+            for(const auto &c:e.get_obj()){
+                m.try_emplace(m.end(),c.first,SharedElement(c.second));
+            }
+            data=std::make_shared<Node>(Node{std::move(m)});
+        }
+    }
+    
+    SharedElement::SharedElement(Element &&e){
+        if(e.is_str()){
+            data=std::make_shared<Node>(Node{std::move(e.get_str())});
+        }else if(e.is_arr()){
+            array_t a;
+            a.reserve(e.get_arr().size());
+            for(Element &c:e.get_arr()){
+                a.emplace_back(std::move(c));
+            }
+            data=std::make_shared<Node>(Node{std::move(a)});
+        }else if(e.is_obj()){
+            object_t m;
+            drain_members(e.get_obj(),[&](std::string &&key,Element &&value){
+                m.try_emplace(m.end(),std::move(key),SharedElement(std::move(value)));
+            });
+            data=std::make_shared<Node>(Node{std::move(m)});
+        }else{
+            *this=SharedElement(static_cast<const Element&>(e));
+        }
+    }
+    
+    Element SharedElement::to_element() const {
+        if(is_int())return Element(get_int());
+        if(is_double())return Element(get_double());
+        if(is_lit())return Element(get_lit());
+        if(is_str())return Element(get_str());
+        if(is_arr()){
+            std::vector<Element> a;
+            a.reserve(get_arr().size());
+            for(const SharedElement &c:get_arr()){
+                a.emplace_back(c.to_element());
+            }
+            return JSON::Array(std::move(a));
+        }
+        Element::object_t m;
+        for(const auto &c:get_obj()){
+            m.try_emplace(m.end(),c.first,c.second.to_element());
+        }
+        return JSON::Object(std::move(m));
+    }
+    
+    const SharedElement& SharedElement::at(size_t i) const {
+        const array_t &a=get_arr();
+        if(i>=a.size()) throw std::out_of_range("Array index "+std::to_string(i)+" out of range");
+        return a[i];
+    }
+    
+    const SharedElement& SharedElement::at(std::string_view key) const {
+        const SharedElement * e=find(key);
+        if(!e) throw std::out_of_range("Key '"+std::string(key)+"' not found");
+        return *e;
+    }
+    
+    const SharedElement* SharedElement::find(std::string_view key) const {
+        const object_t &o=get_obj();
+        auto it=o.find(key);
+        return it==o.end()?nullptr:&it->second;
+    }
+    
+    //the node is copied if any other SharedElement refers to it, the copy is shallow, so the children end up shared by both
+    //use_count() is a relaxed load, the fence orders the writes that follow after other threads' reads of the node, which happened before they released their references
+    SharedElement::Node& SharedElement::unique(){
+        std::shared_ptr<Node> &p=std::get<std::shared_ptr<Node>>(data);
+        if(p.use_count()>1){
+            p=std::make_shared<Node>(*p);
+        }else{
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return *p;
+    }
+    
+    std::string& SharedElement::mut_str(){
+        if(!is_str()) throw std::bad_variant_access();
+        return std::get<std::string>(unique().data);
+    }
+    
+    SharedElement::array_t& SharedElement::mut_arr(){
+        if(!is_arr()) throw std::bad_variant_access();
+        return std::get<array_t>(unique().data);
+    }
+    
+    SharedElement::object_t& SharedElement::mut_obj(){
+        if(!is_obj()) throw std::bad_variant_access();
+        return std::get<object_t>(unique().data);
+    }
+    
+    SharedElement& SharedElement::mut_at(size_t i){
+        if(i>=get_arr().size()) throw std::out_of_range("Array index "+std::to_string(i)+" out of range");
+        return mut_arr()[i];
+    }
+    
+    SharedElement& SharedElement::mut_at(std::string_view key){
+        if(!find(key)) throw std::out_of_range("Key '"+std::string(key)+"' not found");
+        return mut_obj().find(key)->second;
+    }
+    
+    std::string SharedElement::to_json(bool trailing_quote,size_t depth,bool ascii_only) const {
+        std::string out;
+        write_json(*this,out,nullptr,true,trailing_quote,depth,ascii_only);
+        return out;
+    }
+    
+    void SharedElement::to_json(std::string &out,bool trailing_quote,size_t depth,bool ascii_only) const {
+        write_json(*this,out,nullptr,true,trailing_quote,depth,ascii_only);
+    }
+    
+    std::string SharedElement::to_json_min(bool ascii_only) const {
+        std::string out;
+        write_json(*this,out,nullptr,false,false,0,ascii_only);
+        return out;
+    }
+    
+    void SharedElement::to_json_min(std::string &out,bool ascii_only) const {
+        write_json(*this,out,nullptr,false,false,0,ascii_only);
+    }
+
+}
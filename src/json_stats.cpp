@@ -0,0 +1,110 @@
+#include "json_stats.h"
+#include "json_parser.h"
+#include "json_writer.h"
+
+namespace JSON {
+    
+    using namespace internal;
+    
+    namespace {
+        
+        std::string dump_counters(const std::vector<std::pair<std::string,uint64_t>> &counters){
+            std::string out;
+            for(const auto &c:counters){
+                out+=c.first;
+                out+=' ';
+                out+=std::to_string(c.second);
+                out+='\n';
+            }
+            return out;
+        }
+        
+    }
+    
+    std::vector<std::pair<std::string,uint64_t>> ParseStats::counters(const std::string &prefix) const {
+        return {
+            {prefix+".bytes",bytes},
+            {prefix+".total_ns",total_ns},
+            {prefix+".whitespace_ns",whitespace_ns},
+            {prefix+".string_ns",string_ns},
+            {prefix+".number_ns",number_ns},
+            {prefix+".build_ns",build_ns},
+            {prefix+".ints",ints},
+            {prefix+".doubles",doubles},
+            {prefix+".strings",strings},
+            {prefix+".arrays",arrays},
+            {prefix+".objects",objects},
+            {prefix+".literals",literals},
+            {prefix+".keys",keys},
+            {prefix+".max_depth",max_depth},
+            {prefix+".escapes",escapes},
+            {prefix+".allocations",allocations},
+            {prefix+".allocated_bytes",allocated_bytes},
+        };
+    }
+    
+    std::string ParseStats::dump(const std::string &prefix) const {
+        return dump_counters(counters(prefix));
+    }
+    
+    std::vector<std::pair<std::string,uint64_t>> SerializeStats::counters(const std::string &prefix) const {
+        return {
+            {prefix+".bytes",bytes},
+            {prefix+".total_ns",total_ns},
+            {prefix+".string_ns",string_ns},
+            {prefix+".number_ns",number_ns},
+            {prefix+".ints",ints},
+            {prefix+".doubles",doubles},
+            {prefix+".strings",strings},
+            {prefix+".arrays",arrays},
+            {prefix+".objects",objects},
+            {prefix+".literals",literals},
+            {prefix+".keys",keys},
+            {prefix+".max_depth",max_depth},
+            {prefix+".escapes",escapes},
+            {prefix+".allocations",allocations},
+            {prefix+".allocated_bytes",allocated_bytes},
+        };
+    }
+    
+    std::string SerializeStats::dump(const std::string &prefix) const {
+        return dump_counters(counters(prefix));
+    }
+    
+    Element parse(std::string_view data,ParseStats &stats,const ParseOptions &options){
+        stats=ParseStats();
+        ElementBuilder b;
+        Parser<ElementBuilder,true> p(data,b,0,options);
+        p.stats=&stats;
+        p.get_element();
+        return b.take();
+    }
+    
+    void parse(std::string_view data,Handler &h,ParseStats &stats,const ParseOptions &options){
+        stats=ParseStats();
+        Parser<Handler,true> p(data,h,0,options);
+        p.stats=&stats;
+        p.get_element();
+    }
+    
+    void to_json(const Element &e,std::string &out,SerializeStats &stats,bool trailing_quote,size_t depth,bool ascii_only){
+        stats=SerializeStats();
+        size_t start=out.size();
+        {
+            phase_timer<true,SerializeStats> t(&stats,&SerializeStats::total_ns);
+            write_json<true>(e,out,nullptr,true,trailing_quote,depth,ascii_only,&stats);
+        }
+        stats.bytes=out.size()-start;
+    }
+    
+    void to_json_min(const Element &e,std::string &out,SerializeStats &stats,bool ascii_only){
+        stats=SerializeStats();
+        size_t start=out.size();
+        {
+            phase_timer<true,SerializeStats> t(&stats,&SerializeStats::total_ns);
+            write_json<true>(e,out,nullptr,false,false,0,ascii_only,&stats);
+        }
+        stats.bytes=out.size()-start;
+    }
+
+}
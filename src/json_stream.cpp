@@ -0,0 +1,400 @@
+#include "json_stream.h"
+#include "json_parser.h"
+
+namespace JSON {
+    
+    using namespace internal;
+    
+    namespace {
+        
+        constexpr bool is_number_char(char c){
+            return is_number(c)||c=='.'||c=='-'||c=='+'||c=='e'||c=='E';
+        }
+        
+    }
+    
+    StreamParser::StreamParser(Handler &handler,const ParseOptions &opts) : h(handler), options(opts) {}
+    
+    bool StreamParser::idle() const {
+        return mode!=STRING&&mode!=NUMBER&&mode!=LITERAL&&state==VALUE&&stack.empty();
+    }
+    
+    void StreamParser::feed(const char * data,size_t len){
+        run(data,len,consumed);
+        consumed+=len;
+    }
+    
+    void StreamParser::run(const char * data,size_t len,size_t at){
+        size_t k=0;
+        while(k<len){
+            switch(mode){
+            case STRUCTURE:
+                k=scan().whitespace(data,k,len);
+                if(k<len){
+                    structure(data[k],at+k);
+                    k++;
+                }
+                break;
+            case STRING:{
+                    size_t start=k;
+                    if(escaped){
+                        escaped=false;
+                        k++;
+                    }
+                    k=scan().string_special(data,k,len);
+                    token.append(data+start,k-start);
+                    if(k==len){
+                        check_token(at+k);
+                        break;
+                    }
+                    if(data[k]=='"'){
+                        k++;
+                        end_string(at+k);
+                    }else{
+                        if(data[k]=='\\')escaped=true;
+                        plain=false;
+                        token+=data[k];
+                        k++;
+                    }
+                }
+                break;
+            case NUMBER:{
+                    size_t start=k;
+                    while(k<len&&is_number_char(data[k]))k++;
+                    token.append(data+start,k-start);
+                    if(token.size()>max_number_length) throw std::runtime_error("Number length exceeds the maximum of "+std::to_string(max_number_length)+" at pos "+std::to_string(token_start+max_number_length));
+                    if(k<len)end_number(data+k,at+k);
+                }
+                break;
+            case LITERAL:
+                if(data[k]!=literal[token.size()]){
+                    mode=STRUCTURE;
+                    unexpected(literal[0],token_start);
+                }
+                token+=data[k];
+                k++;
+                if(literal[token.size()]=='\0'){
+                    mode=STRUCTURE;
+                    h.on_literal(literal[0]=='n'?JSON_NULL:literal[0]=='t'?JSON_TRUE:JSON_FALSE);
+                    value_done();
+                }
+                break;
+            case SLASH:
+                if(data[k]=='/'){
+                    mode=LINE_COMMENT;
+                }else if(data[k]=='*'){
+                    mode=BLOCK_COMMENT;
+                    star=false;
+                }else{
+                    mode=STRUCTURE;
+                    unexpected('/',token_start);
+                }
+                k++;
+                break;
+            case LINE_COMMENT:
+                while(k<len&&data[k]!='\n')k++;
+                if(k<len){
+                    mode=STRUCTURE;
+                    k++;
+                }
+                break;
+            case BLOCK_COMMENT:
+                while(k<len){
+                    char c=data[k++];
+                    if(star&&c=='/'){
+                        mode=STRUCTURE;
+                        break;
+                    }
+                    star=c=='*';
+                }
+                break;
+            }
+        }
+    }
+    
+    void StreamParser::structure(char c,size_t pos){
+        if(c=='/'){
+            mode=SLASH;
+            token_start=pos;
+            return;
+        }
+        switch(state){
+        case VALUE:
+        case VALUE_OR_END:
+            if(c==']'&&state==VALUE_OR_END){
+                stack.pop_back();
+                h.on_array_end();
+                value_done();
+                break;
+            }
+            if(state==VALUE_OR_END)member(pos);
+            if(c=='['||c=='{'){
+                open(c,pos);
+            }else if(c=='"'){
+                mode=STRING;
+                is_key=false;
+            }else if(is_number(c)||c=='.'||c=='-'||c=='+'){
+                mode=NUMBER;
+            }else if(c=='n'||c=='t'||c=='f'){
+                mode=LITERAL;
+                literal=c=='n'?"null":c=='t'?"true":"false";
+            }else{
+                unexpected(c,pos);
+            }
+            break;
+        case ARRAY_SEP:
+            if(c==','){
+                state=VALUE_OR_END;
+            }else if(c==']'){
+                stack.pop_back();
+                h.on_array_end();
+                value_done();
+            }else{
+                unexpected(c,pos);
+            }
+            break;
+        case KEY_OR_END:
+            if(c=='}'){
+                stack.pop_back();
+                h.on_object_end();
+                value_done();
+            }else if(c=='"'){
+                member(pos);
+                mode=STRING;
+                is_key=true;
+            }else{
+                unexpected(c,pos);
+            }
+            break;
+        case COLON:
+            if(c!=':')unexpected(c,pos);
+            state=VALUE;
+            break;
+        case OBJECT_SEP:
+            if(c==','){
+                state=KEY_OR_END;
+            }else if(c=='}'){
+                stack.pop_back();
+                h.on_object_end();
+                value_done();
+            }else{
+                unexpected(c,pos);
+            }
+            break;
+        }
+        if(mode!=STRUCTURE){//started a token
+            token_start=pos;
+            if(mode==STRING){
+                token.clear();
+                plain=true;
+                escaped=false;
+            }else{
+                token.assign(1,c);
+            }
+        }
+    }
+    
+    void StreamParser::open(char c,size_t pos){
+        if(stack.size()>=options.max_depth) throw std::runtime_error("Maximum depth of "+std::to_string(options.max_depth)+" exceeded at pos "+std::to_string(pos));
+        stack.push_back({c,0});
+        if(c=='['){
+            h.on_array_start();
+            state=VALUE_OR_END;
+        }else{
+            h.on_object_start();
+            state=KEY_OR_END;
+        }
+    }
+    
+    //counts a new element or key of the innermost container
+    void StreamParser::member(size_t pos){
+        if(++stack.back().members>options.max_members) throw std::runtime_error("Container has more than the maximum of "+std::to_string(options.max_members)+" members at pos "+std::to_string(pos));
+    }
+    
+    void StreamParser::value_done(){
+        state=stack.empty()?VALUE:stack.back().bracket=='['?ARRAY_SEP:OBJECT_SEP;
+    }
+    
+    //bounds the buffer of a string that continues past the end of what was fed, its exact length is checked once it ends
+    void StreamParser::check_token(size_t pos){
+        size_t max=options.max_string_length>SIZE_MAX/6?SIZE_MAX:options.max_string_length*6;
+        if(token.size()>max) throw std::runtime_error("String length exceeds the maximum of "+std::to_string(options.max_string_length)+" at pos "+std::to_string(pos));
+    }
+    
+    //pos is just past the closing quote
+    void StreamParser::end_string(size_t pos){
+        mode=STRUCTURE;
+        std::string_view s=token;
+        if(options.strict_strings){
+            //what read_string checks while it scans, the escapes themselves are checked by decode_string
+            for(size_t j=0;j<token.size();){
+                uint8_t c=static_cast<uint8_t>(token[j]);
+                if(c=='\\'){
+                    j+=2;
+                }else if(c<0x20){
+                    throw std::runtime_error("Unescaped control character in string at pos "+std::to_string(token_start+1+j));
+                }else if(c<0x80){
+                    j++;
+                }else{
+                    uint32_t cp;
+                    size_t len=decode_utf8(token,j,cp);
+                    if(len==0) throw std::runtime_error("Invalid UTF-8 in string at pos "+std::to_string(token_start+1+j));
+                    j+=len;
+                }
+            }
+        }
+        if(!plain){
+            decode_string(token,scratch,options.strict_strings,token_start+1);
+            s=scratch;
+        }
+        if(s.size()>options.max_string_length) throw std::runtime_error("String length "+std::to_string(s.size())+" exceeds the maximum of "+std::to_string(options.max_string_length)+" at pos "+std::to_string(pos));
+        if(is_key){
+            h.on_key(s);
+            state=COLON;
+        }else{
+            h.on_string(s);
+            value_done();
+        }
+    }
+    
+    void StreamParser::end_number(const char * next,size_t next_pos){
+        mode=STRUCTURE;
+        if(!is_number_start(token,0)) unexpected(token[0],token_start);
+        size_t j=0;
+        Number n;
+        try{
+            n=get_number(token,j);
+        }catch(std::range_error &){
+            throw std::range_error("Number out of range at pos "+std::to_string(token_start));
+        }catch(std::runtime_error &){
+            if(j<token.size()){
+                throw std::runtime_error(std::string("Expected Number, got '")+token[j]+"' at pos "+std::to_string(token_start+j));
+            }else if(next){
+                throw std::runtime_error(std::string("Expected Number, got '")+*next+"' at pos "+std::to_string(next_pos));
+            }else{
+                throw std::runtime_error("Expected Number, got EOF");
+            }
+        }
+        if(n.is_double){
+            h.on_double(n.d);
+        }else{
+            h.on_int(n.i);
+        }
+        value_done();
+        if(j<token.size()){//characters that looked like part of the number but weren't, ex. "1-2", feed them again as regular input
+            std::string rest=token.substr(j);
+            run(rest.data(),rest.size(),token_start+j);
+        }
+    }
+    
+    void StreamParser::unexpected(char c,size_t pos) const {
+        std::string expected;
+        switch(state){
+        case VALUE:
+        case VALUE_OR_END:
+            expected="JSON";
+            break;
+        case ARRAY_SEP:
+        case OBJECT_SEP:
+            expected="','";
+            break;
+        case KEY_OR_END:
+            expected="'\\\"'";
+            break;
+        case COLON:
+            expected="':'";
+            break;
+        }
+        throw std::runtime_error("Expected "+expected+", got '"+c+"' at pos "+std::to_string(pos));
+    }
+    
+    void StreamParser::unexpected_eof() const {
+        if(mode==STRING) throw std::runtime_error("Expected '\"', got EOF");
+        switch(state){
+        case VALUE:
+            throw std::runtime_error("Expected JSON, got EOF");
+        case VALUE_OR_END:
+            throw std::runtime_error("Expected ']', got EOF");
+        case ARRAY_SEP:
+        case OBJECT_SEP:
+            throw std::runtime_error("Expected ',', got EOF");
+        case KEY_OR_END:
+            throw std::runtime_error("Expected '}', got EOF");
+        case COLON:
+            throw std::runtime_error("Expected ':', got EOF");
+        }
+        __builtin_unreachable();
+    }
+    
+    void StreamParser::finish(){
+        while(mode==NUMBER)end_number(nullptr,consumed);
+        if(mode==STRING)unexpected_eof();
+        if(mode==LITERAL){
+            mode=STRUCTURE;
+            unexpected(literal[0],token_start);
+        }
+        if(mode==SLASH){
+            mode=STRUCTURE;
+            unexpected('/',token_start);
+        }
+        if(state!=VALUE||!stack.empty())unexpected_eof();
+        mode=STRUCTURE;
+        consumed=0;
+    }
+    
+    void ElementStream::Collector::check(){
+        if(builder.done())ready.emplace_back(builder.take());
+    }
+    
+    void ElementStream::Collector::on_object_start(){
+        builder.on_object_start();
+    }
+    
+    void ElementStream::Collector::on_key(std::string_view key){
+        builder.on_key(key);
+    }
+    
+    void ElementStream::Collector::on_object_end(){
+        builder.on_object_end();
+        check();
+    }
+    
+    void ElementStream::Collector::on_array_start(){
+        builder.on_array_start();
+    }
+    
+    void ElementStream::Collector::on_array_end(){
+        builder.on_array_end();
+        check();
+    }
+    
+    void ElementStream::Collector::on_string(std::string_view s){
+        builder.on_string(s);
+        check();
+    }
+    
+    void ElementStream::Collector::on_int(int64_t i){
+        builder.on_int(i);
+        check();
+    }
+    
+    void ElementStream::Collector::on_double(double d){
+        builder.on_double(d);
+        check();
+    }
+    
+    void ElementStream::Collector::on_literal(JSON_Literal l){
+        builder.on_literal(l);
+        check();
+    }
+    
+    ElementStream::ElementStream(const ParseOptions &options) : collector(ready), parser(collector,options) {}
+    
+    Element ElementStream::next(){
+        if(ready.empty()) throw std::out_of_range("No completed values");
+        Element e(std::move(ready.front()));
+        ready.pop_front();
+        return e;
+    }
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+//internal: runs batches of independent tasks on several threads, tasks are claimed one at a time from a shared counter so uneven tasks balance out
+//threads are started for each batch and joined before it returns, there's no persistent pool
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace JSON {
+    
+    namespace internal {
+        
+        inline size_t default_threads(){
+            unsigned n=std::thread::hardware_concurrency();
+            return n?n:1;
+        }
+        
+        //joins every thread it holds when it goes out of scope, so no path leaves a joinable std::thread behind
+        struct thread_group {
+            std::vector<std::thread> threads;
+            
+            inline ~thread_group(){
+                for(std::thread &t:threads){
+                    if(t.joinable())t.join();
+                }
+            }
+        };
+        
+        //calls fn(i) for every i in [0,count), on up to threads new threads (0 for one per core), the calling thread is one of them
+        //if a task throws, the remaining unclaimed tasks are skipped and the first exception is rethrown once all threads have stopped
+        //if a thread can't be started, the tasks are shared by the threads that are already running
+        template<typename F>
+        void spawn_for(size_t count,size_t threads,F &&fn){
+            if(threads==0)threads=default_threads();
+            threads=std::min(threads,count);
+            if(threads<=1){
+                for(size_t i=0;i<count;i++)fn(i);
+                return;
+            }
+            std::atomic<size_t> next{0};
+            std::exception_ptr error;
+            std::mutex error_mutex;
+            auto work=[&](){
+                try{
+                    for(size_t i;(i=next.fetch_add(1,std::memory_order_relaxed))<count;){
+                        fn(i);
+                    }
+                }catch(...){
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if(!error)error=std::current_exception();
+                    next.store(count,std::memory_order_relaxed);
+                }
+            };
+            {
+                thread_group group;
+                group.threads.reserve(threads-1);
+                for(size_t t=1;t<threads;t++){
+                    try{
+                        group.threads.emplace_back(work);
+                    }catch(const std::system_error &){
+                        break;
+                    }
+                }
+                work();
+            }
+            if(error)std::rethrow_exception(error);
+        }
+        
+    }
+
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+//internal serializer shared by Element::to_json/to_json_min, SharedElement and the instrumented overloads in json_stats.h
+
+#include "json_parser.h"
+#include <ostream>
+
+namespace JSON {
+    
+    namespace internal {
+        
+        inline void append_indent(std::string &out,size_t depth){
+            out.append(depth*4,' ');
+        }
+        
+        constexpr size_t stream_flush_size=64*1024;
+        
+        //when writing to a stream, the buffer is flushed every time it grows past stream_flush_size, so memory use stays bounded regardless of document size
+        inline void maybe_flush(std::string &out,std::ostream *os){
+            if(os&&out.size()>=stream_flush_size){
+                os->write(out.data(),out.size());
+                out.clear();
+            }
+        }
+        
+        //characters of s that append_quoted writes as escape sequences
+        inline size_t count_escapes(std::string_view s,bool ascii_only){
+            size_t n=0;
+            for(size_t j=0;(j=ascii_only?find_escape_ascii(s,j):find_escape(s,j))<s.size();n++){
+                uint32_t cp;
+                size_t len=static_cast<uint8_t>(s[j])>=0x80?decode_utf8(s,j,cp):1;
+                j+=len?len:1;
+            }
+            return n;
+        }
+        
+        template<bool Stats>
+        inline void write_string(std::string &out,std::string_view s,bool ascii_only,SerializeStats *stats){
+            phase_timer<Stats,SerializeStats> t(stats,&SerializeStats::string_ns);
+            append_quoted(out,s,ascii_only);
+            if constexpr(Stats)stats->escapes+=count_escapes(s,ascii_only);
+        }
+        
+        template<bool Stats,typename E>
+        bool write_scalar(const E &e,std::string &out,bool ascii_only,SerializeStats *stats){
+            if(e.is_int()){//int
+                phase_timer<Stats,SerializeStats> t(stats,&SerializeStats::number_ns);
+                append_int(out,e.get_int());
+                if constexpr(Stats)stats->ints++;
+            }else if(e.is_double()){//double
+                phase_timer<Stats,SerializeStats> t(stats,&SerializeStats::number_ns);
+                append_double(out,e.get_double());
+                if constexpr(Stats)stats->doubles++;
+            }else if(e.is_str()){//string
+                write_string<Stats>(out,e.get_str(),ascii_only,stats);
+                if constexpr(Stats)stats->strings++;
+            }else if(e.is_lit()){//literal
+                out+=e.get_lit()==JSON_TRUE?"true":e.get_lit()==JSON_FALSE?"false":"null";
+                if constexpr(Stats)stats->literals++;
+            }else{
+                return false;
+            }
+            return true;
+        }
+        
+        //iterative, with an explicit stack of open containers, so deeply nested trees can't overflow the call stack
+        //with Stats, counts and phase times are added to *stats, and every growth of out is recorded
+        //E is Element or SharedElement, anything with the same type checks and getters works
+        template<bool Stats=false,typename E>
+        void write_json(const E &root,std::string &out,std::ostream *os,bool pretty,bool trailing_quote,size_t depth,bool ascii_only,SerializeStats *stats=nullptr){
+            struct frame {
+                const E * e;
+                size_t index;//next array element
+                typename E::object_t::const_iterator it;//next object member
+            };
+            std::vector<frame> stack;
+            size_t capacity=out.capacity();
+            auto track=[&](){
+                if constexpr(Stats){
+                    if(out.capacity()!=capacity){
+                        capacity=out.capacity();
+                        stats->allocations++;
+                        stats->allocated_bytes+=capacity;
+                    }
+                }
+            };
+            const E * e=&root;
+            while(e){
+                if(write_scalar<Stats>(*e,out,ascii_only,stats)){
+                    //nothing to open
+                }else if(e->is_arr()){
+                    out+=pretty?"[\n":"[";
+                    stack.push_back({e,0,{}});
+                    if constexpr(Stats)stats->arrays++;
+                }else{
+                    out+=pretty?"{\n":"{";
+                    stack.push_back({e,0,e->get_obj().begin()});
+                    if constexpr(Stats)stats->objects++;
+                }
+                if constexpr(Stats)stats->max_depth=std::max(stats->max_depth,stack.size());
+                e=nullptr;
+                while(!stack.empty()){
+                    track();
+                    maybe_flush(out,os);
+                    frame &f=stack.back();
+                    size_t child_depth=depth+stack.size();
+                    if(f.e->is_arr()){
+                        const auto &arr=f.e->get_arr();
+                        if(f.index<arr.size()){
+                            if(f.index)out+=pretty?",\n":",";
+                            if(pretty)append_indent(out,child_depth);
+                            e=&arr[f.index++];
+                            break;
+                        }
+                        if(pretty){
+                            if(!arr.empty())out+=trailing_quote?",\n":"\n";
+                            append_indent(out,child_depth-1);
+                        }
+                        out+=']';
+                    }else{
+                        const typename E::object_t &obj=f.e->get_obj();
+                        if(f.it!=obj.end()){
+                            if(f.it!=obj.begin())out+=pretty?",\n":",";
+                            if(pretty)append_indent(out,child_depth);
+                            write_string<Stats>(out,f.it->first,ascii_only,stats);
+                            if constexpr(Stats)stats->keys++;
+                            out+=pretty?" : ":":";
+                            e=&f.it->second;
+                            ++f.it;
+                            break;
+                        }
+                        if(pretty){
+                            if(!obj.empty())out+=trailing_quote?",\n":"\n";
+                            append_indent(out,child_depth-1);
+                        }
+                        out+='}';
+                    }
+                    stack.pop_back();
+                }
+            }
+            track();
+        }
+        
+    }
+
+}
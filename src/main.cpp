@@ -1,22 +1,11 @@
 #include <iostream>
-#include <fstream>
-#include <sstream>
-#include <cerrno>
-#include <cstring>
-#include <windows.h>
 #include "json.h"
+#include "json_file.h"
 
-static std::string readfile(const std::string &filename){
-    std::ostringstream ss;
-    std::ifstream f(filename);
-    if(!f)throw std::runtime_error(strerror(errno));
-    ss<<f.rdbuf();
-    return ss.str();
-}
-
-int main() {
-    std::string file=readfile("test.json");
-    JSON::Element elem(JSON::parse(file));
+int main(int argc,char ** argv) {
+    JSON::FileStats stats;
+    JSON::Element elem(JSON::parse_file(argc>1?argv[1]:"test.json",&stats));
     std::cout<<elem.to_json()<<"\n";
+    std::cerr<<stats.file_size<<" bytes, "<<(stats.mapped?"mapped":"read")<<", "<<stats.bytes_read<<" bytes read, "<<stats.minor_faults<<" minor and "<<stats.major_faults<<" major page faults, "<<stats.pages_resident<<" pages resident\n";
     return 0;
 }
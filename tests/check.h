@@ -0,0 +1,45 @@
+#pragma once
+
+//minimal assertions for the tests, a failed check is reported and counted, main returns the result of finish()
+
+#include <cstdio>
+#include <exception>
+#include <string>
+
+namespace check {
+    
+    inline int failures=0;
+    
+    inline void report(bool ok,const char * what,const char * file,int line){
+        if(!ok){
+            std::fprintf(stderr,"%s:%d: check failed: %s\n",file,line,what);
+            failures++;
+        }
+    }
+    
+    //runs fn and checks that it throws an exception whose message contains message
+    template<typename F>
+    void throws(F &&fn,const std::string &message,const char * what,const char * file,int line){
+        try{
+            fn();
+        }catch(const std::exception &e){
+            if(std::string(e.what()).find(message)==std::string::npos){
+                std::fprintf(stderr,"%s:%d: %s threw '%s', expected '%s'\n",file,line,what,e.what(),message.c_str());
+                failures++;
+            }
+            return;
+        }
+        std::fprintf(stderr,"%s:%d: %s didn't throw, expected '%s'\n",file,line,what,message.c_str());
+        failures++;
+    }
+    
+    inline int finish(){
+        if(failures) std::fprintf(stderr,"%d check(s) failed\n",failures);
+        return failures?1:0;
+    }
+
+}
+
+#define CHECK(cond) check::report((cond),#cond,__FILE__,__LINE__)
+#define CHECK_EQ(a,b) check::report((a)==(b),#a " == " #b,__FILE__,__LINE__)
+#define CHECK_THROWS(expr,message) check::throws([&]{ expr; },message,#expr,__FILE__,__LINE__)
@@ -0,0 +1,112 @@
+#include "json_bind.h"
+#include "check.h"
+#include <functional>
+#include <map>
+#include <optional>
+
+namespace {
+    
+    struct Ids {
+        uint64_t id;
+        unsigned long big;
+        uint8_t small;
+        int64_t neg;
+        JSON_FIELDS(id,big,small,neg)
+    };
+    
+    struct Node {
+        std::vector<Node> c;
+        JSON_FIELDS(c)
+    };
+    
+    struct Record {
+        std::string name;
+        std::optional<double> score;
+        std::vector<int> tags;
+        std::map<std::string,std::string> attributes;
+        JSON::Element extra;
+        JSON_FIELDS(name,score,tags,attributes,extra)
+    };
+    
+    void round_trip(){
+        Record r=JSON::parse_into<Record>(R"({"name":"a\u00e9","unknown":[1,{"x":2}],"score":1.5,"tags":[1,2],"attributes":{"k":"v"},"extra":{"z":[null]},"name":"ignored"})");
+        CHECK_EQ(r.name,"a\xc3\xa9");
+        CHECK(r.score&&*r.score==1.5);
+        CHECK_EQ(r.tags.size(),2u);
+        CHECK_EQ(r.attributes["k"],"v");
+        CHECK_EQ(r.extra.to_json_min(),"{\"z\":[null]}");
+        CHECK_EQ(JSON::to_json(r),"{\"name\":\"a\xc3\xa9\",\"score\":1.5,\"tags\":[1,2],\"attributes\":{\"k\":\"v\"},\"extra\":{\"z\":[null]}}");
+        CHECK_THROWS(JSON::parse_into<Record>("{\"name\":1}"),"Expected String, got Number at pos 8");
+    }
+    
+    void unsigned_values(){
+        Ids ids{UINT64_MAX,1ul<<63,255,INT64_MIN};
+        std::string s=JSON::to_json(ids);
+        CHECK_EQ(s,"{\"id\":18446744073709551615,\"big\":9223372036854775808,\"small\":255,\"neg\":-9223372036854775808}");
+        Ids back=JSON::parse_into<Ids>(s);
+        CHECK(back.id==ids.id&&back.big==ids.big&&back.small==ids.small&&back.neg==ids.neg);
+        CHECK_THROWS(JSON::parse_into<Ids>("{\"id\":-1}"),"out of range");
+        CHECK_THROWS(JSON::parse_into<Ids>("{\"id\":18446744073709551616}"),"out of range");
+        CHECK_THROWS(JSON::parse_into<Ids>("{\"small\":256}"),"out of range");
+        CHECK_THROWS(JSON::parse_into<Ids>("{\"id\":1.5}"),"Expected Int, got Double");
+    }
+    
+    std::string nested_nodes(size_t levels){
+        std::string s;
+        for(size_t j=0;j<levels;j++)s+="{\"c\":[";
+        for(size_t j=0;j<levels;j++)s+="]}";
+        return s;
+    }
+    
+    std::string error(std::function<void()> fn){
+        try{
+            fn();
+        }catch(const std::exception &e){
+            return e.what();
+        }
+        return "";
+    }
+    
+    void limits(){
+        //a million levels are rejected on the depth limit, with the same message as parse, instead of overflowing the stack
+        std::string deep=nested_nodes(1000000);
+        std::string expected=error([&]{ JSON::parse(deep); });
+        CHECK_EQ(expected,"Maximum depth of 1024 exceeded at pos 3072");
+        CHECK_EQ(error([&]{ JSON::parse_into<Node>(deep); }),expected);
+        CHECK_EQ(JSON::to_json(JSON::parse_into<Node>(nested_nodes(512))),nested_nodes(512));
+        JSON::ParseOptions o;
+        o.max_depth=4;
+        CHECK_EQ(JSON::to_json(JSON::parse_into<Node>(nested_nodes(2),o)),nested_nodes(2));
+        CHECK_THROWS(JSON::parse_into<Node>(nested_nodes(3),o),"Maximum depth of 4 exceeded at pos 12");
+        //values that are skipped or read as Elements count the containers around them
+        CHECK_THROWS(JSON::parse_into<Record>("{\"unknown\":[[[[]]]]}",o),"Maximum depth of 4 exceeded at pos 14");
+        CHECK_THROWS(JSON::parse_into<Record>("{\"extra\":[[[[]]]]}",o),"Maximum depth of 4 exceeded at pos 12");
+        CHECK(JSON::parse_into<Record>("{\"extra\":[[[]]]}",o).extra.is_arr());
+        o=JSON::ParseOptions();
+        o.max_members=2;
+        CHECK_EQ(JSON::parse_into<Record>("{\"tags\":[1,2]}",o).tags.size(),2u);
+        CHECK_THROWS(JSON::parse_into<Record>("{\"tags\":[1,2,3]}",o),"maximum of 2 members at pos 13");
+        CHECK_THROWS(JSON::parse_into<Record>("{\"name\":\"\",\"score\":1,\"tags\":[]}",o),"maximum of 2 members at pos 21");
+        CHECK_THROWS(JSON::parse_into<Record>("{\"unknown\":[1,2,3]}",o),"maximum of 2 members");
+        o=JSON::ParseOptions();
+        o.max_string_length=4;
+        CHECK_EQ(JSON::parse_into<Record>("{\"name\":\"abcd\"}",o).name,"abcd");
+        CHECK_THROWS(JSON::parse_into<Record>("{\"name\":\"abcde\"}",o),"String length 5 exceeds the maximum of 4 at pos 15");
+        CHECK_THROWS(JSON::parse_into<Record>("{\"unknown\":1}",o),"String length 7 exceeds the maximum of 4 at pos 10");
+        o=JSON::ParseOptions();
+        o.strict_strings=true;
+        CHECK_THROWS(JSON::parse_into<Record>("{\"name\":\"\\ud800\"}",o),"Unpaired surrogate");
+        CHECK_THROWS(JSON::parse_into<Record>("{\"extra\":\"\\a\"}",o),"Invalid escape");
+        o=JSON::ParseOptions();
+        o.max_size=8;
+        CHECK_THROWS(JSON::parse_into<Record>("{\"tags\":[]}",o),"Document size 11 exceeds the maximum of 8");
+    }
+
+}
+
+int main(){
+    round_trip();
+    unsigned_values();
+    limits();
+    return check::finish();
+}
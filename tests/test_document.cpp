@@ -0,0 +1,77 @@
+#include "json.h"
+#include "json_document.h"
+#include "check.h"
+#include <random>
+
+namespace {
+    
+    //Document must build the same tree as parse, keeping the first of duplicate keys and, with JSON_ORDERED_OBJECTS, document order
+    void same_as_parse(){
+        const char * docs[]={
+            "{\"z\":1,\"a\":2,\"m\":3}",
+            "{\"b\":1,\"a\":2,\"b\":3,\"c\":{\"y\":1,\"x\":[{\"q\":1,\"p\":2,\"q\":3}]},\"a\":9}",
+            "{}",
+            "[{\"k\":\"v\"},[],1.5,-3,true,null]",
+        };
+        for(const char * d:docs){
+            CHECK_EQ(JSON::Document::parse(d).root().to_element().to_json_min(),JSON::parse(d).to_json_min());
+        }
+    }
+    
+    void find(){
+        std::mt19937 rng(3);
+        for(int n=0;n<2000;n++){
+            std::string d="{";
+            for(uint32_t j=0,count=rng()%30;j<count;j++){
+                if(j)d+=",";
+                d+="\"k"+std::to_string(rng()%12)+"\":"+std::to_string(j);
+            }
+            d+="}";
+            JSON::Document doc=JSON::Document::parse_view(d);
+            JSON::Element e=JSON::parse(d);
+            CHECK_EQ(doc.root().to_element().to_json_min(),e.to_json_min());
+            JSON::ObjectView o=doc.root().get_obj();
+            for(int k=0;k<14;k++){
+                std::string key="k"+std::to_string(k);
+                auto expected=e.get_obj().find(key);
+                auto found=o.find(key);
+                CHECK_EQ(found!=o.end(),expected!=e.get_obj().end());
+                if(found!=o.end()&&expected!=e.get_obj().end())CHECK_EQ(found->second.get_int(),expected->second.get_int());
+            }
+        }
+    }
+    
+    void limits(){
+        JSON::ParseOptions o;
+        o.max_depth=2;
+        o.max_members=3;
+        o.max_string_length=4;
+        o.strict_strings=true;
+        const char * ok="{\"abcd\":[1,2,3],\"e\":\"\u00e9\"}";
+        CHECK_EQ(JSON::Document::parse(ok,o).root().to_element().to_json_min(),JSON::parse(ok).to_json_min());
+        const char * rejected[]={"[[[]]]","[1,2,3,4]","[\"abcde\"]","{\"abcde\":1}","[\"\\ud800\"]","[\"\xff\"]"};
+        for(const char * d:rejected){
+            std::string expected;
+            try{
+                JSON::parse(d,o);
+            }catch(const std::exception &e){
+                expected=e.what();
+            }
+            CHECK(!expected.empty());
+            CHECK_THROWS(JSON::Document::parse(d,o),expected);
+            CHECK_THROWS(JSON::Document::parse_view(d,o),expected);
+        }
+        CHECK_THROWS(JSON::Document::parse(std::string(1025,'['),JSON::ParseOptions()),"Maximum depth of 1024 exceeded at pos 1024");
+        o=JSON::ParseOptions();
+        o.max_size=3;
+        CHECK_THROWS(JSON::Document::parse_view("[12]",o),"Document size 4 exceeds the maximum of 3");
+    }
+
+}
+
+int main(){
+    same_as_parse();
+    find();
+    limits();
+    return check::finish();
+}
@@ -0,0 +1,69 @@
+#include "json_file.h"
+#include "check.h"
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#if defined(__unix__)||defined(__APPLE__)
+#include <sys/stat.h>
+#endif
+
+namespace {
+    
+    const std::string document=R"({"name":"file","values":[1,2.5,"x",null],"nested":{"deep":[[{}]]}})";
+    
+    std::string temp_path(const char * name){
+        return (std::filesystem::temp_directory_path()/(std::string("json_test_")+name)).string();
+    }
+    
+    void mapped(){
+        std::string path=temp_path("mapped.json");
+        {
+            std::ofstream f(path,std::ios::binary);
+            f<<document;
+        }
+        JSON::FileStats stats;
+        JSON::Element e=JSON::parse_file(path,&stats);
+        CHECK_EQ(e.to_json_min(),JSON::parse(document).to_json_min());
+        CHECK_EQ(stats.file_size,document.size());
+        CHECK(stats.mapped);
+        CHECK_EQ(stats.bytes_read,0u);
+        CHECK_EQ(stats.pages_resident,1u);
+        JSON::MappedFile f(path);
+        JSON::MappedFile moved(std::move(f));
+        CHECK(moved.data()==document);
+        CHECK_EQ(f.size(),0u);
+        std::filesystem::remove(path);
+        CHECK_THROWS(JSON::parse_file(path),path);
+    }
+    
+    //pipes can't be mapped, they're read into a buffer instead
+    void read_fallback(){
+#if defined(__unix__)||defined(__APPLE__)
+        std::string path=temp_path("fifo.json");
+        std::filesystem::remove(path);
+        CHECK(mkfifo(path.c_str(),0600)==0);
+        std::thread writer([&]{
+            std::ofstream f(path,std::ios::binary);
+            for(int j=0;j<1000;j++)f<<(j?",":"[")<<document;
+            f<<"]";
+        });
+        JSON::FileStats stats;
+        JSON::Element e=JSON::parse_file(path,&stats);
+        writer.join();
+        CHECK(!stats.mapped);
+        CHECK_EQ(e.get_arr().size(),1000u);
+        CHECK_EQ(e.get_arr()[999].to_json_min(),JSON::parse(document).to_json_min());
+        CHECK_EQ(stats.bytes_read,stats.file_size);
+        CHECK_EQ(stats.file_size,1000*(document.size()+1)+1);
+        std::filesystem::remove(path);
+#endif
+    }
+
+}
+
+int main(){
+    mapped();
+    read_fallback();
+    return check::finish();
+}
@@ -0,0 +1,89 @@
+#include "json_lazy.h"
+#include "check.h"
+#include <variant>
+
+namespace {
+    
+    const char * document=R"({"b":1,"a":{"x":[10,20,30]},"b":2,"s":"t\u00e9","list":[true,null,1.5,"x"],"b":3})";
+    
+    void lookup(){
+        JSON::LazyDocument doc(document);
+        JSON::LazyValue root=doc.root();
+        CHECK(root.is_obj()&&!root.is_arr());
+        //lookup keeps the first of duplicate keys, same as parse
+        CHECK_EQ(root["b"].get_int(),1);
+        CHECK_EQ(root["a"]["x"][2].get_int(),30);
+        CHECK_EQ(root["s"].get_str(),"t\xc3\xa9");
+        CHECK(root["list"][1].is_null());
+        CHECK(root.contains("list")&&!root.contains("missing"));
+        CHECK_EQ(root["a"].get().to_json_min(),"{\"x\":[10,20,30]}");
+        CHECK_EQ(root.get().to_json_min(),JSON::parse(document).to_json_min());
+        CHECK_EQ(root["a"].position(),11u);
+        CHECK_THROWS(root["missing"],"Key 'missing' not found");
+        CHECK_THROWS(root["list"][4],"Array index 4 out of range");
+        CHECK_THROWS(root["s"][0],"");
+        CHECK_EQ(root["a"].key(),"a");
+        CHECK_THROWS(root.key(),"Value is not an object member");
+        bool bad_variant=false;
+        try{
+            root["list"]["k"];
+        }catch(const std::bad_variant_access &){
+            bad_variant=true;
+        }
+        CHECK(bad_variant);
+    }
+    
+    //size() and iteration walk the members as they are in the document, duplicates included
+    void iteration(){
+        JSON::LazyDocument doc(document);
+        JSON::LazyValue root=doc.root();
+        CHECK_EQ(root.size(),6u);
+        CHECK_EQ(root.get().get_obj().size(),4u);
+        std::string keys;
+        int64_t b_sum=0;
+        for(JSON::LazyValue v:root){
+            keys+=v.key()+",";
+            if(v.key()=="b")b_sum+=v.get_int();
+        }
+        CHECK_EQ(keys,"b,a,b,s,list,b,");
+        CHECK_EQ(b_sum,6);
+        std::string list;
+        for(JSON::LazyValue v:root["list"])list+=v.get().to_json_min()+" ";
+        CHECK_EQ(list,"true null 1.5 \"x\" ");
+        CHECK_EQ(root["a"]["x"].size(),3u);
+        CHECK_EQ(JSON::LazyDocument("[]").root().size(),0u);
+    }
+    
+    void errors_and_limits(){
+        const char * invalid[]={"{\"a\":[1,2}","[1,,2]","{\"a\" 1}","[\"unterminated"};
+        for(const char * d:invalid){
+            std::string expected;
+            try{
+                JSON::parse(d);
+            }catch(const std::exception &e){
+                expected=e.what();
+            }
+            CHECK_THROWS(JSON::LazyDocument{d},expected);
+        }
+        JSON::ParseOptions o;
+        o.max_members=2;
+        o.strict_strings=true;
+        CHECK_THROWS(JSON::LazyDocument("[1,2,3]",o),"maximum of 2 members");
+        CHECK_THROWS(JSON::LazyDocument("[\"\\ud800\"]",o),"Unpaired surrogate");
+        CHECK_THROWS(JSON::LazyDocument(std::string(1025,'[')),"Maximum depth of 1024 exceeded at pos 1024");
+        //values are materialized with the document's options, so a deeper limit still holds for get()
+        std::string deep=std::string(2000,'[')+std::string(2000,']');
+        o=JSON::ParseOptions();
+        o.max_depth=2000;
+        JSON::LazyDocument doc(deep,o);
+        CHECK_EQ(doc.root().get().to_json_min(),deep);
+    }
+
+}
+
+int main(){
+    lookup();
+    iteration();
+    errors_and_limits();
+    return check::finish();
+}
@@ -0,0 +1,84 @@
+#include "json.h"
+#include "json_parallel.h"
+#include "json_stream.h"
+#include "check.h"
+
+namespace {
+    
+    JSON::Element stream(std::string_view doc,const JSON::ParseOptions &o){
+        JSON::ElementStream s(o);
+        s.feed(doc);
+        s.finish();
+        return s.next();
+    }
+    
+    std::string nested(size_t depth){
+        return std::string(depth,'[')+std::string(depth,']');
+    }
+    
+    void depth(){
+        CHECK_EQ(JSON::parse(nested(1024)).to_json_min(),nested(1024));
+        CHECK_THROWS(JSON::parse(nested(1025)),"Maximum depth of 1024 exceeded at pos 1024");
+        CHECK_THROWS(stream(nested(1025),JSON::ParseOptions()),"Maximum depth of 1024 exceeded at pos 1024");
+        CHECK_THROWS(JSON::parse_parallel(nested(1025)),"Maximum depth of 1024 exceeded at pos 1024");
+        //deep input is rejected once the limit is reached, not after reading all of it
+        CHECK_THROWS(JSON::parse(std::string(1000000,'[')),"Maximum depth of 1024 exceeded");
+        CHECK_THROWS(stream(std::string(1000000,'['),JSON::ParseOptions()),"Maximum depth of 1024 exceeded");
+        JSON::ParseOptions o;
+        o.max_depth=2;
+        CHECK_EQ(JSON::parse("[{\"a\":1}]",o).to_json_min(),"[{\"a\":1}]");
+        CHECK_THROWS(JSON::parse("[{\"a\":[]}]",o),"Maximum depth of 2 exceeded at pos 6");
+        CHECK_THROWS(stream("[{\"a\":[]}]",o),"Maximum depth of 2 exceeded at pos 6");
+    }
+    
+    //tokens that continue past the end of what was fed are buffered, but not without bound
+    void stream_tokens(){
+        JSON::ElementStream s;
+        s.feed("[");
+        std::string digits(1000,'1');
+        CHECK_THROWS(for(int j=0;j<1000;j++)s.feed(digits),"Number length exceeds the maximum of 4096 at pos 4097");
+        std::string longest="0."+std::string(JSON::StreamParser::max_number_length-3,'0')+"7";
+        JSON::ElementStream ok;
+        for(char c:longest)ok.feed(&c,1);
+        ok.feed(" ");
+        CHECK(ok.has_next()&&ok.next().is_double());
+        JSON::ParseOptions o;
+        o.max_string_length=4;
+        JSON::ElementStream strings(o);
+        strings.feed("[\"");
+        CHECK_THROWS(for(int j=0;j<100;j++)strings.feed("ab"),"String length exceeds the maximum of 4");
+        //literals are matched a byte at a time, so a wrong or overlong one fails at once
+        JSON::ElementStream literals;
+        literals.feed("[tr");
+        literals.feed("ue,nul");
+        CHECK_THROWS(literals.feed("ll]"),"Expected ',', got 'l' at pos 10");
+        CHECK_THROWS(stream("[trux]",JSON::ParseOptions()),"Expected JSON, got 't' at pos 1");
+    }
+    
+    void other_limits(){
+        JSON::ParseOptions o;
+        o.max_members=2;
+        CHECK_EQ(JSON::parse("[1,2]",o).to_json_min(),"[1,2]");
+        CHECK_THROWS(JSON::parse("[1,2,3]",o),"maximum of 2 members");
+        CHECK_THROWS(JSON::parse("{\"a\":1,\"b\":2,\"c\":3}",o),"maximum of 2 members");
+        CHECK_THROWS(stream("[1,2,3]",o),"maximum of 2 members");
+        o=JSON::ParseOptions();
+        o.max_string_length=3;
+        CHECK_EQ(JSON::parse("[\"abc\",\"\\u00e9\"]",o).to_json_min(),"[\"abc\",\"\xc3\xa9\"]");
+        CHECK_THROWS(JSON::parse("[\"abcd\"]",o),"exceeds the maximum of 3");
+        CHECK_THROWS(JSON::parse("{\"abcd\":1}",o),"exceeds the maximum of 3");
+        CHECK_THROWS(stream("[\"abcd\"]",o),"exceeds the maximum of 3");
+        o=JSON::ParseOptions();
+        o.max_size=4;
+        CHECK_EQ(JSON::parse("[12]",o).get_arr().size(),1u);
+        CHECK_THROWS(JSON::parse("[123]",o),"exceeds the maximum of 4");
+    }
+
+}
+
+int main(){
+    depth();
+    other_limits();
+    stream_tokens();
+    return check::finish();
+}
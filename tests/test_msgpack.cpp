@@ -0,0 +1,80 @@
+#include "json.h"
+#include "json_msgpack.h"
+#include "check.h"
+
+namespace {
+    
+    void formats(){
+        //integers use the smallest format that holds them
+        CHECK_EQ(JSON::to_msgpack(JSON::Int(127)),std::string("\x7f"));
+        CHECK_EQ(JSON::to_msgpack(JSON::Int(-32)),std::string("\xe0"));
+        CHECK_EQ(JSON::to_msgpack(JSON::Int(128)),std::string("\xcc\x80"));
+        CHECK_EQ(JSON::to_msgpack(JSON::Int(-33)),std::string("\xd0\xdf"));
+        CHECK_EQ(JSON::to_msgpack(JSON::Int(65536)),std::string("\xce\x00\x01\x00\x00",5));
+        CHECK_EQ(JSON::to_msgpack(JSON::Int(INT64_MIN)),std::string("\xd3\x80\x00\x00\x00\x00\x00\x00\x00",9));
+        CHECK_EQ(JSON::to_msgpack(JSON::Double(1.5)),std::string("\xcb\x3f\xf8\x00\x00\x00\x00\x00\x00",9));
+        CHECK_EQ(JSON::to_msgpack(JSON::parse("[null,true,false]")),std::string("\x93\xc0\xc3\xc2"));
+        //string and container lengths switch format at their boundaries
+        CHECK_EQ(JSON::to_msgpack(JSON::String(std::string(31,'a'))).substr(0,1),"\xbf");
+        CHECK_EQ(JSON::to_msgpack(JSON::String(std::string(32,'a'))).substr(0,2),"\xd9\x20");
+        CHECK_EQ(JSON::to_msgpack(JSON::String(std::string(256,'a'))).substr(0,3),std::string("\xda\x01\x00",3));
+        CHECK_EQ(JSON::to_msgpack(JSON::String(std::string(65536,'a'))).substr(0,5),std::string("\xdb\x00\x01\x00\x00",5));
+        CHECK_EQ(JSON::to_msgpack(JSON::Array(std::vector<JSON::Element>(16))).substr(0,3),std::string("\xdc\x00\x10",3));
+    }
+    
+    void round_trip(){
+        JSON::Element e=JSON::parse("{\"a\":[1,{\"b\":[]},{}],\"c\":\"x\",\"d\":[[[2.5]]],\"e\":-70000,\"f\":9223372036854775807,\"g\":\"\xc3\xa9\"}");
+        CHECK_EQ(JSON::from_msgpack(JSON::to_msgpack(e)).to_json_min(),e.to_json_min());
+        std::string big(70000,'x');
+        JSON::Element s=JSON::Array({JSON::String(big),JSON::Array(std::vector<JSON::Element>(70000,JSON::Int(1)))});
+        CHECK(JSON::from_msgpack(JSON::to_msgpack(s)).to_json_min()==s.to_json_min());
+        //bin, float 32 and uint 64 above INT64_MAX
+        CHECK_EQ(JSON::from_msgpack(std::string("\xc4\x02hi",4)).get_str(),"hi");
+        CHECK_EQ(JSON::from_msgpack(std::string("\xca\x3f\xc0\x00\x00",5)).get_double(),1.5);
+        CHECK_EQ(JSON::from_msgpack(std::string("\xcf\xff\xff\xff\xff\xff\xff\xff\xff",9)).get_double(),18446744073709551615.0);
+        //duplicate keys, first one wins
+        CHECK_EQ(JSON::from_msgpack(std::string("\x82\xa1k\x01\xa1k\x02",7)).to_json_min(),"{\"k\":1}");
+    }
+    
+    void errors(){
+        CHECK_THROWS(JSON::from_msgpack(std::string("\x92\x01",2)),"Expected MessagePack, got EOF");
+        CHECK_THROWS(JSON::from_msgpack(std::string("\x01\x02",2)),"Expected EOF, got MessagePack at pos 1");
+        CHECK_THROWS(JSON::from_msgpack(std::string("\x81\x01\x02",3)),"Expected MessagePack string key");
+        CHECK_THROWS(JSON::from_msgpack(std::string("\xd4\x01\x02",3)),"Unsupported MessagePack type");
+    }
+    
+    void limits(){
+        //a million nested arrays fail on the depth limit instead of overflowing the stack
+        std::string deep(1000000,'\x91');
+        deep+='\xc0';
+        CHECK_THROWS(JSON::from_msgpack(deep),"Maximum depth of 1024 exceeded");
+        JSON::ParseOptions o;
+        o.max_depth=5000;
+        std::string nested(5000,'\x91');
+        nested+='\xc0';
+        CHECK(JSON::to_msgpack(JSON::from_msgpack(nested,o))==nested);
+        o=JSON::ParseOptions();
+        o.max_members=2;
+        CHECK_THROWS(JSON::from_msgpack("\x93\x01\x02\x03",o),"maximum of 2 members");
+        o=JSON::ParseOptions();
+        o.max_string_length=2;
+        CHECK_THROWS(JSON::from_msgpack("\x81\xa3""abc\x01",o),"exceeds the maximum of 2");
+        o=JSON::ParseOptions();
+        o.max_size=3;
+        CHECK_THROWS(JSON::from_msgpack("\x93\x01\x02\x03",o),"exceeds the maximum of 3");
+        o=JSON::ParseOptions();
+        o.strict_strings=true;
+        std::string invalid("\x92\x01\xa2\xc3\x28",5);
+        CHECK_THROWS(JSON::from_msgpack(invalid,o),"Invalid UTF-8");
+        CHECK_EQ(JSON::from_msgpack(invalid).get_arr().size(),2u);
+    }
+
+}
+
+int main(){
+    formats();
+    round_trip();
+    errors();
+    limits();
+    return check::finish();
+}
@@ -0,0 +1,85 @@
+#include "json_ndjson.h"
+#include "check.h"
+
+namespace {
+    
+    std::string error(std::string_view line,const JSON::ParseOptions &o=JSON::ParseOptions()){
+        try{
+            JSON::parse(line,o);
+        }catch(const std::exception &e){
+            return e.what();
+        }
+        return "";
+    }
+    
+    void records(){
+        std::string data="{\"a\":1}\n\n  [1,2] \"x\"\n{\"bad\":}\ntrue\n[1,\n  \n3";
+        std::vector<JSON::Record> r=JSON::parse_lines(data);
+        CHECK_EQ(r.size(),7u);
+        if(r.size()!=7)return;
+        CHECK(r[0].ok()&&r[0].value.to_json_min()=="{\"a\":1}"&&r[0].line==1&&r[0].offset==0);
+        //several documents on one line are separate records
+        CHECK(r[1].ok()&&r[1].value.to_json_min()=="[1,2]"&&r[1].line==3&&r[1].offset==11);
+        CHECK(r[2].ok()&&r[2].value.get_str()=="x"&&r[2].line==3&&r[2].offset==17);
+        //a bad record gets the error parse gives for its line, and the next line is still read
+        CHECK(!r[3].ok()&&r[3].value.is_null()&&r[3].line==4&&r[3].offset==21);
+        CHECK_EQ(r[3].error,error("{\"bad\":}"));
+        CHECK(r[4].ok()&&r[4].value.get_bool()&&r[4].line==5);
+        //documents don't continue across lines
+        CHECK(!r[5].ok()&&r[5].line==6);
+        CHECK_EQ(r[5].error,error("[1,"));
+        CHECK(r[6].ok()&&r[6].value.get_int()==3&&r[6].line==8&&r[6].offset==data.size()-1);
+    }
+    
+    //the records come back in input order, with the same line numbers, however the input is split
+    void chunking(){
+        std::string data;
+        for(int j=0;j<5000;j++){
+            data+=j%7==3?"{\"broken\":\n":"{\"n\":"+std::to_string(j)+"}\n";
+            if(j%11==0)data+="\n";
+        }
+        JSON::BatchOptions single;
+        single.threads=1;
+        single.chunk_size=data.size();
+        std::vector<JSON::Record> expected=JSON::parse_lines(data,single);
+        CHECK_EQ(expected.size(),5000u);
+        for(size_t chunk_size:{1,17,4096}){
+            JSON::BatchOptions o;
+            o.threads=4;
+            o.chunk_size=chunk_size;
+            std::vector<JSON::Record> r=JSON::parse_lines(data,o);
+            bool same=r.size()==expected.size();
+            for(size_t j=0;same&&j<r.size();j++){
+                same=r[j].line==expected[j].line&&r[j].offset==expected[j].offset&&r[j].error==expected[j].error&&r[j].value.to_json_min()==expected[j].value.to_json_min();
+            }
+            CHECK(same);
+        }
+    }
+    
+    void limits(){
+        JSON::BatchOptions o;
+        o.parse_options.max_string_length=3;
+        o.parse_options.max_depth=2;
+        o.parse_options.strict_strings=true;
+        std::vector<JSON::Record> r=JSON::parse_lines("[\"abc\"]\n[\"abcd\"]\n[[[1]]]\n[\"\\ud800\"]\n[[1]]\n",o);
+        CHECK_EQ(r.size(),5u);
+        if(r.size()!=5)return;
+        CHECK(r[0].ok());
+        CHECK_EQ(r[1].error,error("[\"abcd\"]",o.parse_options));
+        CHECK_EQ(r[2].error,"Maximum depth of 2 exceeded at pos 2");
+        CHECK_EQ(r[3].error,error("[\"\\ud800\"]",o.parse_options));
+        CHECK(r[4].ok());
+        o=JSON::BatchOptions();
+        o.parse_options.max_size=5;
+        r=JSON::parse_lines("[1,2]\n[1,23]\n",o);
+        CHECK(r.size()==2&&r[0].ok()&&!r[1].ok());
+    }
+
+}
+
+int main(){
+    records();
+    chunking();
+    limits();
+    return check::finish();
+}
@@ -0,0 +1,61 @@
+#include "json.h"
+#include "check.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+
+namespace {
+    
+    void doubles_round_trip(){
+        std::mt19937_64 rng(1);
+        size_t tested=0;
+        while(tested<200000){
+            uint64_t bits=rng();
+            double d;
+            std::memcpy(&d,&bits,sizeof(d));
+            if(!std::isfinite(d))continue;
+            tested++;
+            std::string s=JSON::Double(d).to_json_min();
+            JSON::Element e=JSON::parse(s);
+            uint64_t back=0;
+            if(e.is_double()){
+                double r=e.get_double();
+                std::memcpy(&back,&r,sizeof(r));
+            }
+            if(back!=bits){
+                CHECK(back==bits);
+                std::fprintf(stderr,"  %s\n",s.c_str());
+                return;
+            }
+        }
+    }
+    
+    void integers(){
+        CHECK_EQ(JSON::parse("9223372036854775807").get_int(),INT64_MAX);
+        CHECK_EQ(JSON::parse("-9223372036854775808").get_int(),INT64_MIN);
+        CHECK(JSON::parse("9223372036854775808").is_double());
+        CHECK_EQ(JSON::parse("12345678901234567890").get_double(),12345678901234567890.0);
+        CHECK_EQ(JSON::parse("[1,-0,2]").to_json_min(),"[1,0,2]");
+        CHECK_EQ(JSON::parse("[1.0,-0.0,2.5e-3]").to_json_min(),"[1.0,-0.0,0.0025]");
+    }
+    
+    void out_of_range(){
+        CHECK_THROWS(JSON::parse("1e400"),"Number out of range at pos 0");
+        CHECK_THROWS(JSON::parse("[1, -1e400]"),"Number out of range at pos 4");
+        CHECK_THROWS(JSON::parse("{\"a\":123456789e999}"),"Number out of range at pos 5");
+        CHECK_EQ(JSON::parse("1e-400").get_double(),0.0);
+        CHECK_EQ(JSON::parse("1.7976931348623157e308").get_double(),std::numeric_limits<double>::max());
+        JSON::Element e=JSON::Array({JSON::Double(INFINITY),JSON::Double(-INFINITY),JSON::Double(NAN),JSON::Double(1.5)});
+        CHECK_EQ(e.to_json_min(),"[null,null,null,1.5]");
+        CHECK_EQ(JSON::parse(e.to_json()).to_json_min(),"[null,null,null,1.5]");
+    }
+
+}
+
+int main(){
+    doubles_round_trip();
+    integers();
+    out_of_range();
+    return check::finish();
+}
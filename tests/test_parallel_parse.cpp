@@ -0,0 +1,139 @@
+#include "json.h"
+#include "json_parallel.h"
+#include "check.h"
+#include <random>
+
+namespace {
+    
+    std::mt19937_64 rng(7);
+    
+    size_t random(size_t n){
+        return rng()%n;
+    }
+    
+    //whitespace and comments, including ones that contain separators and quotes
+    void gen_space(std::string &o){
+        static const char * parts[]={" ","\n  ","/* c, [ \" } */","// x, ] \" {\n","/**/","/*/ , **/"};
+        size_t r=random(8);
+        if(r<6)o+=parts[r];
+    }
+    
+    void gen_string(std::string &o){
+        static const char * parts[]={"a","[","]","{","}",",","\\\"","\\\\","//","/*","*/","\\n","\\u00e9","x y"," \n "};
+        o+='"';
+        for(size_t j=random(5);j>0;j--)o+=parts[random(15)];
+        o+='"';
+    }
+    
+    void gen_value(std::string &o,int depth,size_t wide){
+        gen_space(o);
+        size_t r=depth>5?random(4):random(7);
+        if(r==0){
+            o+=std::to_string(static_cast<int64_t>(random(100000))-500);
+        }else if(r==1){
+            gen_string(o);
+        }else if(r==2){
+            o+=random(2)?"true":"null";
+        }else if(r==3){
+            o+="1.5e3";
+        }else{
+            bool object=r==5;
+            size_t n=depth==0?wide:(depth<3&&random(6)==0?random(60):random(5));
+            o+=object?'{':'[';
+            for(size_t j=0;j<n;j++){
+                if(j)o+=',';
+                gen_space(o);
+                if(object){
+                    gen_string(o);
+                    gen_space(o);
+                    o+=':';
+                }
+                gen_value(o,depth+1,wide);
+                gen_space(o);
+            }
+            if(n&&random(8)==0)o+=',';
+            gen_space(o);
+            o+=object?'}':']';
+        }
+        gen_space(o);
+    }
+    
+    std::string result(std::string_view doc,const JSON::ParseOptions &o,const JSON::ParallelParseOptions *pp){
+        try{
+            return (pp?JSON::parse_parallel(doc,o,*pp):JSON::parse(doc,o)).to_json_min();
+        }catch(const std::exception &e){
+            return std::string("E:")+e.what();
+        }
+    }
+    
+    //parse_parallel must give the same value, or the same error, as parse on valid, damaged and limited documents
+    void parse_equivalence(){
+        int mismatches=0;
+        for(int n=0;n<6000;n++){
+            std::string doc;
+            size_t mode=random(4);
+            if(mode==0){
+                doc="{\"meta\":";
+                gen_value(doc,2,0);
+                doc+=",\"data\":";
+                gen_value(doc,0,random(300));
+                doc+="}";
+            }else if(mode==1){
+                doc="[[";
+                gen_value(doc,0,random(300));
+                doc+="]]";
+            }else{
+                gen_value(doc,0,random(300));
+            }
+            if(random(3)==0&&!doc.empty()){
+                size_t p=random(doc.size());
+                switch(random(3)){
+                    case 0:
+                        doc.erase(p,1);
+                        break;
+                    case 1:
+                        doc.insert(p,1,",]}\"/*["[random(7)]);
+                        break;
+                    default:
+                        doc[p]=",]}\"["[random(5)];
+                }
+            }
+            JSON::ParseOptions o;
+            if(random(4)==0)o.max_members=random(100);
+            if(random(4)==0)o.max_depth=random(6);
+            if(random(6)==0)o.strict_strings=true;
+            JSON::ParallelParseOptions pp;
+            pp.threads=2+random(4);
+            pp.chunk_size=1+random(64);
+            std::string a=result(doc,o,nullptr);
+            std::string b=result(doc,o,&pp);
+            if(a!=b&&mismatches++<3){
+                CHECK_EQ(a,b);
+                std::fprintf(stderr,"  %s\n  %s\n  %s\n",doc.c_str(),a.c_str(),b.c_str());
+            }
+        }
+        CHECK_EQ(mismatches,0);
+    }
+    
+    //a document several default chunks long, with separators inside strings and comments that the scan has to skip
+    void large_document(){
+        std::string doc="{\"meta\":{\"n\":1},\"items\":[";
+        for(int j=0;j<60000;j++){
+            if(j)doc+=j%100?",":",/* , ] } */\n";
+            doc+="{\"id\":"+std::to_string(j)+",\"text\":\"a, [b] {c} \\\" d // e\",\"values\":[1.5,true,null]}";
+        }
+        doc+="]}";
+        JSON::ParallelParseOptions pp;
+        pp.threads=4;
+        CHECK_EQ(result(doc,JSON::ParseOptions(),&pp),result(doc,JSON::ParseOptions(),nullptr));
+        doc.insert(doc.size()/2,"]");
+        CHECK_EQ(result(doc,JSON::ParseOptions(),&pp),result(doc,JSON::ParseOptions(),nullptr));
+    }
+
+}
+
+int main(){
+    parse_equivalence();
+    large_document();
+    return check::finish();
+}
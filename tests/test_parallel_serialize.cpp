@@ -0,0 +1,78 @@
+#include "json.h"
+#include "json_parallel.h"
+#include "check.h"
+#include <random>
+
+namespace {
+    
+    std::mt19937_64 rng(11);
+    
+    size_t random(size_t n){
+        return rng()%n;
+    }
+    
+    JSON::Element gen_value(int depth,size_t wide){
+        static const char * strings[]={"","a","\"quoted\"","back\\slash","new\nline","\xc3\xa9t\xc3\xa9","\xf0\x9f\x98\x80","\x01\x1f"};
+        size_t r=depth>4?random(4):random(6);
+        switch(r){
+            case 0:
+                return JSON::Int(static_cast<int64_t>(rng()));
+            case 1:
+                return JSON::Double(static_cast<double>(static_cast<int64_t>(rng()))/1e6);
+            case 2:
+                return JSON::String(strings[random(8)]);
+            case 3:
+                return random(3)?JSON::Boolean(random(2)):JSON::Null();
+            case 4:{
+                std::vector<JSON::Element> v;
+                for(size_t j=depth==0?wide:random(8);j>0;j--)v.push_back(gen_value(depth+1,wide));
+                return JSON::Array(std::move(v));
+            }
+            default:{
+                JSON::Element::object_t o;
+                for(size_t j=depth==0?wide:random(8);j>0;j--)o.try_emplace("k"+std::to_string(random(100000))+strings[random(8)],gen_value(depth+1,wide));
+                return JSON::Object(std::move(o));
+            }
+        }
+    }
+    
+    //the parallel serializers must match the sequential ones byte for byte, with any split of the work
+    void equivalence(){
+        for(int n=0;n<200;n++){
+            JSON::Element e=gen_value(0,random(3000));
+            JSON::SerializeOptions so;
+            so.threads=2+random(4);
+            so.chunk_size=1+random(4096);
+            so.ascii_only=random(2);
+            size_t depth=random(3);
+            bool trailing_quote=random(2);
+            CHECK_EQ(JSON::to_json_min_parallel(e,so),e.to_json_min(so.ascii_only));
+            CHECK_EQ(JSON::to_json_parallel(e,trailing_quote,depth,so),e.to_json(trailing_quote,depth,so.ascii_only));
+            std::string out="prefix";
+            JSON::to_json_min_parallel(e,out,so);
+            CHECK_EQ(out,"prefix"+e.to_json_min(so.ascii_only));
+        }
+    }
+    
+    //a large array and a large object, split with the default chunk size
+    void large(){
+        std::vector<JSON::Element> v;
+        JSON::Element::object_t o;
+        for(int j=0;j<200000;j++){
+            v.push_back(JSON::String("item "+std::to_string(j)));
+            o.try_emplace("key"+std::to_string(j),JSON::Array({JSON::Int(j),JSON::Double(j/4.0)}));
+        }
+        JSON::Element e=JSON::Array({JSON::Array(std::move(v)),JSON::Object(std::move(o))});
+        JSON::SerializeOptions so;
+        so.threads=4;
+        CHECK_EQ(JSON::to_json_min_parallel(e,so),e.to_json_min());
+        CHECK_EQ(JSON::to_json_parallel(e,true,0,so),e.to_json());
+    }
+
+}
+
+int main(){
+    equivalence();
+    large();
+    return check::finish();
+}
@@ -0,0 +1,70 @@
+#include "json_query.h"
+#include "check.h"
+#include <stdexcept>
+
+namespace {
+    
+    std::string dump(const std::vector<JSON::Element> &matches){
+        std::string s;
+        for(const JSON::Element &e:matches)s+=e.to_json_min()+";";
+        return s;
+    }
+    
+    void pointers(){
+        JSON::Query q({"","/a/b","/list/1","/missing","/list/9","/a/b/c","/dup"});
+        CHECK_EQ(q.size(),7u);
+        auto r=q.run(R"({"a":{"b":[1,2]},"list":[10,{"x":null},30],"dup":1,"dup":2})");
+        CHECK_EQ(r.size(),7u);
+        CHECK_EQ(dump(r[0]),JSON::parse(R"({"a":{"b":[1,2]},"list":[10,{"x":null},30],"dup":1})").to_json_min()+";");
+        CHECK_EQ(dump(r[1]),"[1,2];");
+        CHECK_EQ(dump(r[2]),"{\"x\":null};");
+        CHECK(r[3].empty()&&r[4].empty()&&r[5].empty());
+        //for duplicate keys the first one wins, same as parse
+        CHECK_EQ(dump(r[6]),"1;");
+    }
+    
+    void wildcards(){
+        JSON::Query q({"/items/*/id","/items/*","/obj/*","/items/0/id"});
+        auto r=q.run(R"({"items":[{"id":1},{"name":"x"},{"id":3}],"obj":{"*":"star","k":"v"}})");
+        CHECK_EQ(dump(r[0]),"1;3;");
+        CHECK_EQ(dump(r[1]),R"({"id":1};{"name":"x"};{"id":3};)");
+        //on an object "*" only matches a member named "*"
+        CHECK_EQ(dump(r[2]),"\"star\";");
+        CHECK_EQ(dump(r[3]),"1;");
+        CHECK(JSON::Query({"/*"}).run("[]")[0].empty());
+    }
+    
+    void escapes(){
+        JSON::Query q({"/a~1b","/m~0n","/~01","/"});
+        auto r=q.run(R"({"a/b":1,"m~n":2,"~1":3,"":4,"ab":5})");
+        CHECK_EQ(dump(r[0]),"1;");
+        CHECK_EQ(dump(r[1]),"2;");
+        CHECK_EQ(dump(r[2]),"3;");
+        CHECK_EQ(dump(r[3]),"4;");
+        //keys are compared after unescaping the document's strings
+        CHECK_EQ(dump(JSON::Query({"/a~1b"}).run(R"({"a\/b":6})")[0]),"6;");
+        CHECK_THROWS(JSON::Query({"a"}),"");
+        CHECK_THROWS(JSON::Query({"/a~2"}),"");
+        CHECK_THROWS(JSON::Query({"/a~"}),"");
+    }
+    
+    //without a wildcard the scan stops once every pointer has matched, so what comes after isn't validated
+    void early_exit(){
+        CHECK_EQ(dump(JSON::Query({"/a","/b/0"}).run(R"({"a":1,"b":[2],"c":@@@)")[1]),"2;");
+        CHECK_EQ(dump(JSON::Query({""}).run(R"([1] trailing)")[0]),"[1];");
+        //a pointer that never matches, or one with a wildcard, scans the whole document
+        CHECK_THROWS(JSON::Query({"/a","/z"}).run(R"({"a":1,"b" 2})"),"Expected ':', got '2' at pos 11");
+        CHECK_THROWS(JSON::Query({"/z"}).run(R"({"a":1,"b":[1,2)"),"Expected ']', got EOF");
+        CHECK_THROWS(JSON::Query({"/b/*"}).run(R"({"b":[2],"c" 1})"),"Expected ':', got '1' at pos 13");
+        CHECK_THROWS(JSON::Query({"/a"}).run(R"({"b":[1,}")"),"");
+    }
+
+}
+
+int main(){
+    pointers();
+    wildcards();
+    escapes();
+    early_exit();
+    return check::finish();
+}
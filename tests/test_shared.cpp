@@ -0,0 +1,70 @@
+#include "json_shared.h"
+#include "check.h"
+#include <thread>
+
+namespace {
+    
+    const char * document=R"({"a":{"b":[1,2,{"c":"x"}],"d":"big string here"},"e":[true,null,1.5],"f":{}})";
+    
+    void conversion(){
+        JSON::Element e=JSON::parse(document);
+        JSON::SharedElement s(e);
+        CHECK_EQ(s.to_json(),e.to_json());
+        CHECK_EQ(s.to_json_min(),e.to_json_min());
+        CHECK_EQ(s.to_element().to_json_min(),e.to_json_min());
+        JSON::SharedElement moved(JSON::parse(document));
+        CHECK_EQ(moved.to_json_min(),e.to_json_min());
+    }
+    
+    void copy_on_write(){
+        JSON::SharedElement s(JSON::parse(document));
+        JSON::SharedElement snapshot=s;
+        CHECK(snapshot.shares_with(s));
+        s.mut_at("a").mut_at("b").mut_at(2).mut_obj()["c"]=JSON::SharedElement(std::string("y"));
+        CHECK_EQ(s.to_json_min(),R"({"a":{"b":[1,2,{"c":"y"}],"d":"big string here"},"e":[true,null,1.5],"f":{}})");
+        CHECK_EQ(snapshot.to_json_min(),JSON::parse(document).to_json_min());
+        //only the path down to the change was copied
+        CHECK(!s.shares_with(snapshot));
+        CHECK(!s.at("a").shares_with(snapshot.at("a")));
+        CHECK(s.at("a").at("d").shares_with(snapshot.at("a").at("d")));
+        CHECK(s.at("e").shares_with(snapshot.at("e")));
+        CHECK(s.at("f").shares_with(snapshot.at("f")));
+        //the path is no longer shared, so changing it again doesn't copy
+        const JSON::SharedElement * b=&s.at("a").at("b");
+        s.mut_at("a").mut_at("b").mut_arr().push_back(7);
+        CHECK(b==&s.at("a").at("b"));
+        CHECK_EQ(s.at("a").at("b").to_json_min(),"[1,2,{\"c\":\"y\"},7]");
+        CHECK_THROWS(s.at("missing"),"Key 'missing' not found");
+        CHECK_THROWS(s.mut_at(0),"");
+    }
+    
+    void threads(){
+        JSON::SharedElement snapshot(JSON::parse(document));
+        std::string before=snapshot.to_json_min();
+        std::vector<std::string> results(8);
+        std::vector<std::thread> pool;
+        for(size_t t=0;t<results.size();t++){
+            pool.emplace_back([&,t]{
+                JSON::SharedElement mine=snapshot;
+                for(int64_t k=0;k<1000;k++){
+                    mine.mut_at("a").mut_obj()["n"]=JSON::SharedElement(k+static_cast<int64_t>(t));
+                    results[t]=mine.to_json_min();
+                }
+            });
+        }
+        for(std::thread &t:pool)t.join();
+        CHECK_EQ(snapshot.to_json_min(),before);
+        for(size_t t=0;t<results.size();t++){
+            JSON::Element e=JSON::parse(results[t]);
+            CHECK_EQ(e.get_obj().at("a").get_obj().at("n").get_int(),static_cast<int64_t>(999+t));
+        }
+    }
+
+}
+
+int main(){
+    conversion();
+    copy_on_write();
+    threads();
+    return check::finish();
+}
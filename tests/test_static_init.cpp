@@ -0,0 +1,10 @@
+#include "json.h"
+#include "check.h"
+
+//parsed during static initialization, before main, so the scanner can't depend on other globals being initialized
+static JSON::Element config=JSON::parse("[1, 2, {\"a\": \"b\"}]");
+
+int main(){
+    CHECK_EQ(config.to_json_min(),"[1,2,{\"a\":\"b\"}]");
+    return check::finish();
+}
@@ -0,0 +1,87 @@
+#include "json_stats.h"
+#include "check.h"
+
+namespace {
+    
+    //the duplicate "b" is counted by the parser but dropped from the Element, so only the parse counts include it
+    const std::string document=R"( {"a":[1,2.5,"x\ny",true,null,[]],"b":{"c":"é","d":{}},"b":0}  )";
+    
+    void parse_stats(){
+        JSON::ParseStats s;
+        JSON::Element e=JSON::parse(document,s);
+        CHECK_EQ(e.to_json_min(),JSON::parse(document).to_json_min());
+        CHECK_EQ(s.bytes,document.size()-2);
+        CHECK_EQ(s.ints,2u);
+        CHECK_EQ(s.doubles,1u);
+        CHECK_EQ(s.strings,2u);
+        CHECK_EQ(s.arrays,2u);
+        CHECK_EQ(s.objects,3u);
+        CHECK_EQ(s.literals,2u);
+        CHECK_EQ(s.keys,5u);
+        CHECK_EQ(s.max_depth,3u);
+        CHECK_EQ(s.escapes,1u);
+        CHECK(s.allocations>0&&s.allocated_bytes>0);
+        CHECK(s.total_ns>0);
+        CHECK(s.whitespace_ns+s.string_ns+s.number_ns+s.build_ns<=s.total_ns);
+        
+        auto counters=s.counters("p");
+        CHECK_EQ(counters.size(),17u);
+        CHECK_EQ(counters.front().first,"p.bytes");
+        CHECK_EQ(counters.front().second,document.size()-2);
+        CHECK(s.dump().find("json.parse.keys 5\n")!=std::string::npos);
+        
+        //a scalar document still fills in bytes and its one value
+        JSON::ParseStats scalar;
+        JSON::parse("-12",scalar);
+        CHECK_EQ(scalar.bytes,3u);
+        CHECK_EQ(scalar.ints,1u);
+        CHECK_EQ(scalar.max_depth,0u);
+    }
+    
+    void serialize_stats(){
+        JSON::Element e=JSON::parse(document);
+        JSON::SerializeStats s;
+        std::string out;
+        JSON::to_json_min(e,out,s);
+        CHECK_EQ(out,e.to_json_min());
+        CHECK_EQ(s.bytes,out.size());
+        CHECK_EQ(s.ints,1u);
+        CHECK_EQ(s.doubles,1u);
+        CHECK_EQ(s.strings,2u);
+        CHECK_EQ(s.arrays,2u);
+        CHECK_EQ(s.objects,3u);
+        CHECK_EQ(s.literals,2u);
+        CHECK_EQ(s.keys,4u);
+        CHECK_EQ(s.max_depth,3u);
+        CHECK_EQ(s.escapes,1u);
+        CHECK(s.allocations>0&&s.allocated_bytes>=out.size());
+        CHECK(s.string_ns+s.number_ns<=s.total_ns);
+        
+        //with ascii_only the 'é' is escaped too, and the buffer from the last call doesn't have to grow
+        JSON::SerializeStats ascii;
+        size_t capacity=out.capacity();
+        out.clear();
+        JSON::to_json_min(e,out,ascii,true);
+        CHECK(out.size()<=capacity);
+        CHECK_EQ(ascii.escapes,2u);
+        CHECK_EQ(ascii.allocations,0u);
+        CHECK_EQ(ascii.allocated_bytes,0u);
+        
+        JSON::SerializeStats pretty;
+        out.clear();
+        JSON::to_json(e,out,pretty);
+        CHECK_EQ(out,e.to_json());
+        CHECK_EQ(pretty.bytes,out.size());
+        CHECK_EQ(pretty.keys,4u);
+        CHECK_EQ(pretty.max_depth,3u);
+        CHECK_EQ(s.counters().size(),15u);
+        CHECK(s.dump().find("json.serialize.keys 4\n")!=std::string::npos);
+    }
+
+}
+
+int main(){
+    parse_stats();
+    serialize_stats();
+    return check::finish();
+}
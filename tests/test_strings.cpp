@@ -0,0 +1,108 @@
+#include "json.h"
+#include "json_parallel.h"
+#include "json_stream.h"
+#include "check.h"
+
+namespace {
+    
+    JSON::ParseOptions strict(){
+        JSON::ParseOptions o;
+        o.strict_strings=true;
+        return o;
+    }
+    
+    //parse, ElementStream fed one byte at a time, and parse_parallel must agree on both the value and the error
+    std::string parse_all(const std::string &doc,const JSON::ParseOptions &o){
+        std::string a,b,c;
+        try{ a=JSON::parse(doc,o).to_json_min(); }catch(const std::exception &e){ a=std::string("E:")+e.what(); }
+        try{
+            JSON::ElementStream s(o);
+            for(char ch:doc)s.feed(&ch,1);
+            s.finish();
+            b=s.next().to_json_min();
+        }catch(const std::exception &e){ b=std::string("E:")+e.what(); }
+        JSON::ParallelParseOptions pp;
+        pp.threads=3;
+        pp.chunk_size=4;
+        try{ c=JSON::parse_parallel(doc,o,pp).to_json_min(); }catch(const std::exception &e){ c=std::string("E:")+e.what(); }
+        CHECK_EQ(a,b);
+        CHECK_EQ(a,c);
+        return a;
+    }
+    
+    void escapes(){
+        CHECK_EQ(JSON::parse(R"("\/\b\f\n\r\t\"\\")").get_str(),"/\b\f\n\r\t\"\\");
+        CHECK_EQ(JSON::parse(R"("A\u00e9\u20ac")").get_str(),"A\xc3\xa9\xe2\x82\xac");
+        CHECK_EQ(JSON::parse(R"("\ud83d\ude00")").get_str(),"\xf0\x9f\x98\x80");
+        CHECK_EQ(JSON::parse(R"("\uD83D\uDE00x")").get_str(),"\xf0\x9f\x98\x80x");
+        CHECK_EQ(JSON::parse(R"("\u0000")").get_str(),std::string(1,'\0'));
+        //lenient parsing keeps unknown or malformed escapes as the character after the backslash
+        CHECK_EQ(JSON::parse(R"("\uZZ")").get_str(),"uZZ");
+        CHECK_THROWS(JSON::parse(R"("\uZZ")",strict()),"Expected 4 hex digits after '\\u' at pos 1");
+        CHECK_THROWS(JSON::parse(R"(["\u12"])",strict()),"Expected 4 hex digits after '\\u' at pos 2");
+    }
+    
+    void strict_strings(){
+        const char * accepted[]={
+            R"(["plain","\u00e9","\ud83d\ude00","\/\b\f\n\r\t\"\\"])",
+            "[\"\xc3\xa9 caf\xc3\xa9\",\"\xf0\x9f\x98\x80\",\"\xf4\x8f\xbf\xbf\"]",
+            "{\"k\xe2\x82\xac\":\"\\u0001\\u001f\\u007f\"}",
+        };
+        for(const char * d:accepted){
+            std::string r=parse_all(d,strict());
+            CHECK(r.compare(0,2,"E:")!=0);
+            CHECK_EQ(r,parse_all(d,JSON::ParseOptions()));
+        }
+        const char * rejected[]={
+            R"(["\ud83d"])",//unpaired high surrogate
+            R"(["\ude00x"])",//unpaired low surrogate
+            R"(["\ud83d\u0041"])",//high surrogate followed by a non-surrogate
+            R"(["\a"])",//escape RFC 8259 doesn't allow
+            "[\"raw\nnewline\"]",
+            "[\"tab\there\"]",
+            "[\"bad\xc3(\"]",//truncated sequence
+            "[\"\xed\xa0\x80\"]",//encoded surrogate
+            "[\"\xc0\xaf\"]",//overlong
+            "[\"\xf4\x90\x80\x80\"]",//above U+10FFFF
+            "[\"trunc\xe2\x82\"]",
+            "{\"k\xff\":1}",//invalid key
+        };
+        for(const char * d:rejected){
+            CHECK(parse_all(d,strict()).compare(0,2,"E:")==0);
+            parse_all(d,JSON::ParseOptions());
+        }
+    }
+    
+    void ascii_output(){
+        std::string s;
+        for(int c=0;c<128;c++)s+=static_cast<char>(c);
+        s+="\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80";
+        JSON::Element e=JSON::Array({JSON::String(s)});
+        for(bool ascii:{false,true}){
+            std::string j=e.to_json_min(ascii);
+            CHECK_EQ(JSON::parse(j,strict()).get_arr()[0].get_str(),s);
+            if(ascii){
+                bool only_ascii=true;
+                for(char c:j)only_ascii=only_ascii&&static_cast<unsigned char>(c)<0x80;
+                CHECK(only_ascii);
+            }
+        }
+        JSON::SerializeOptions so;
+        so.ascii_only=true;
+        so.threads=2;
+        so.chunk_size=1;
+        std::vector<JSON::Element> v;
+        for(int i=0;i<100;i++)v.push_back(JSON::parse("{\"k\xc3\xa9\":\"\xe2\x82\xac\"}"));
+        JSON::Element a=JSON::Array(std::move(v));
+        CHECK_EQ(JSON::to_json_min_parallel(a,so),a.to_json_min(true));
+        CHECK_EQ(JSON::to_json_parallel(a,true,0,so),a.to_json(true,0,true));
+    }
+
+}
+
+int main(){
+    escapes();
+    strict_strings();
+    ascii_output();
+    return check::finish();
+}